@@ -85,6 +85,10 @@ static char *enum_event_string[] = {
     ENUM_TO_STR(FLEX_BTN_PRESS_LONG_UP),
     ENUM_TO_STR(FLEX_BTN_PRESS_LONG_HOLD),
     ENUM_TO_STR(FLEX_BTN_PRESS_LONG_HOLD_UP),
+    ENUM_TO_STR(FLEX_BTN_PRESS_COMBO),
+    ENUM_TO_STR(FLEX_BTN_PRESS_REPEAT),
+    ENUM_TO_STR(FLEX_BTN_PRESS_STEP),
+    ENUM_TO_STR(FLEX_BTN_PRESS_REPEAT_UP),
     ENUM_TO_STR(FLEX_BTN_PRESS_MAX),
     ENUM_TO_STR(FLEX_BTN_PRESS_NONE),
 };
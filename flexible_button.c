@@ -34,13 +34,236 @@
 #define NULL 0
 #endif
 
-#define EVENT_SET_AND_EXEC_CB(btn, evt)                                        \
+#if defined(FLEX_BTN_USING_EVENT_QUEUE) && defined(FLEX_BTN_USING_EVENT_BATCH)
+#error "FLEX_BTN_USING_EVENT_QUEUE and FLEX_BTN_USING_EVENT_BATCH can not be used together"
+#endif
+
+/* The trace records every scan, the tickless scan skips the scans without changes */
+#if defined(FLEX_BTN_USING_TICKLESS) && defined(FLEX_BTN_USING_TRACE)
+#error "FLEX_BTN_USING_TICKLESS and FLEX_BTN_USING_TRACE can not be used together"
+#endif
+
+/* Events are passed to flex_button_event_push instead of the callbacks */
+#if defined(FLEX_BTN_USING_EVENT_QUEUE) || defined(FLEX_BTN_USING_EVENT_BATCH)
+#define FLEX_BTN_EVENT_PUSH
+#endif
+
+#ifdef FLEX_BTN_EVENT_PUSH
+#define EVENT_SET_AND_EXEC_CB(ctx, btn, i, evt)                                \
+    do                                                                         \
+    {                                                                          \
+        BTN_EVENT(ctx, btn, i) = evt;                                          \
+        if(BTN_HELD(ctx, i))                                                   \
+        {                                                                      \
+            BTN_HOLD_EVENT(ctx, i, BTN_EVENT(ctx, btn, i));                    \
+        }                                                                      \
+        else if(!BTN_SUPPRESSED(ctx, i))                                       \
+        {                                                                      \
+            BTN_STATS_EVENT(ctx, btn, i);                                      \
+            flex_button_event_push(ctx, btn->id, BTN_EVENT(ctx, btn, i),       \
+                BTN_EVENT_CNT(ctx, btn, i), 0);                                \
+        }                                                                      \
+    } while(0)
+#else
+#define EVENT_SET_AND_EXEC_CB(ctx, btn, i, evt)                                \
+    do                                                                         \
+    {                                                                          \
+        BTN_EVENT(ctx, btn, i) = evt;                                          \
+        if(BTN_HELD(ctx, i))                                                   \
+        {                                                                      \
+            BTN_HOLD_EVENT(ctx, i, BTN_EVENT(ctx, btn, i));                    \
+        }                                                                      \
+        else if(!BTN_SUPPRESSED(ctx, i))                                       \
+        {                                                                      \
+            BTN_STATS_EVENT(ctx, btn, i);                                      \
+            if(btn->cb)                                                        \
+            {                                                                  \
+                BTN_SYNC(ctx, btn, i);                                         \
+                BTN_STATS_CB_BEGIN(ctx);                                       \
+                btn->cb((flex_button_t*)btn);                                  \
+                BTN_STATS_CB_END(ctx);                                         \
+            }                                                                  \
+        }                                                                      \
+    } while(0)
+#endif
+
+/**
+ * BTN_SUPPRESSED, BTN_HELD, BTN_HOLD_EVENT
+ * 
+ * The events of the button at index i are not reported, it is used by a
+ * reported combination, or are held until the combination it is waiting
+ * for is reported or given up, only with FLEX_BTN_USING_COMBO.
+*/
+#ifdef FLEX_BTN_USING_COMBO
+#define BTN_SUPPRESSED(ctx, i)       ((ctx)->combo_suppress[BTN_WORD(i)] & BTN_BIT(i))
+#define BTN_HELD(ctx, i)             ((ctx)->combo_hold[BTN_WORD(i)] & BTN_BIT(i))
+#define BTN_HOLD_EVENT(ctx, i, evt)  ((ctx)->combo_held[i] |= (uint16_t)(1U << (evt)))
+#else
+#define BTN_SUPPRESSED(ctx, i)       0
+#define BTN_HELD(ctx, i)             0
+#define BTN_HOLD_EVENT(ctx, i, evt)
+#endif
+
+/**
+ * BTN_REPEATING, BTN_EVENT_CNT
+ * 
+ * The button at index i is held with auto-repeat, or released after a repeat,
+ * and is handled by 'flex_button_repeat' instead of the gestures.
+ * The count of the event queued, 'repeat_cnt' for FLEX_BTN_PRESS_REPEAT.
+ * Only with FLEX_BTN_USING_REPEAT.
+*/
+#ifdef FLEX_BTN_USING_REPEAT
+#define BTN_REPEATING(ctx, btn, i)                                             \
+    ((btn)->repeat_rate_tick &&                                                \
+     (BTN_STATUS(ctx, btn, i) == FLEX_BTN_STAGE_DOWN) &&                       \
+     (BTN_CLICK_CNT(ctx, btn, i) == 0) &&                                      \
+     (BTN_IS_PRESSED(ctx, i) || (btn)->repeat_cnt ||                           \
+      (BTN_SCAN_CNT(ctx, btn, i) >= (btn)->short_press_start_tick)))
+#define BTN_EVENT_CNT(ctx, btn, i)                                             \
+    ((BTN_EVENT(ctx, btn, i) == FLEX_BTN_PRESS_REPEAT) ||                      \
+     (BTN_EVENT(ctx, btn, i) == FLEX_BTN_PRESS_REPEAT_UP) ?                    \
+        (btn)->repeat_cnt : BTN_CLICK_CNT(ctx, btn, i))
+#else
+#define BTN_EVENT_CNT(ctx, btn, i) BTN_CLICK_CNT(ctx, btn, i)
+#endif
+
+/**
+ * BTN_STATS_*
+ * 
+ * Statistics of the scans, the callbacks and the events,
+ * only with FLEX_BTN_USING_STATS.
+*/
+#ifdef FLEX_BTN_USING_STATS
+#define BTN_STATS_EVENT(ctx, btn, i)                                           \
+    flex_button_stats_event(ctx, BTN_EVENT(ctx, btn, i), (ctx)->stats_clock - (ctx)->stats_edge[i])
+#define BTN_STATS_CB_BEGIN(ctx)         ((ctx)->cb_start = FLEX_BTN_CYCLES())
+#define BTN_STATS_CB_END(ctx)           flex_button_stats_cb(ctx, FLEX_BTN_CYCLES() - (ctx)->cb_start)
+#define BTN_STATS_SCAN_BEGIN(ctx)       ((ctx)->scan_start = FLEX_BTN_CYCLES())
+#define BTN_STATS_SCAN_END(ctx, active) flex_button_stats_scan(ctx, active)
+#else
+#define BTN_STATS_EVENT(ctx, btn, i)
+#define BTN_STATS_CB_BEGIN(ctx)
+#define BTN_STATS_CB_END(ctx)
+#define BTN_STATS_SCAN_BEGIN(ctx)
+#define BTN_STATS_SCAN_END(ctx, active) (active)
+#endif
+
+/**
+ * BTN_BATCH_*
+ * 
+ * Collect the events of a scan in an array on the stack of the scan, and pass
+ * them to the batch handler at the end, only with FLEX_BTN_USING_EVENT_BATCH.
+*/
+#ifdef FLEX_BTN_USING_EVENT_BATCH
+#define BTN_BATCH_BEGIN(ctx, buf)       ((ctx)->batch = (buf), (ctx)->batch_num = 0)
+#define BTN_BATCH_END(ctx, active)      flex_button_batch_end(ctx, active)
+#else
+#define BTN_BATCH_BEGIN(ctx, buf)
+#define BTN_BATCH_END(ctx, active)      (active)
+#endif
+
+/**
+ * BTN_SNAPSHOT_*
+ * 
+ * Mark the changes of the scan state for flex_button_snapshot, and copy the
+ * scan state of a button to the context, only with FLEX_BTN_USING_SNAPSHOT.
+*/
+#ifdef FLEX_BTN_USING_SNAPSHOT
+#define BTN_SNAPSHOT_BEGIN(ctx)         flex_button_snapshot_begin(ctx)
+#define BTN_SNAPSHOT_END(ctx)           flex_button_snapshot_end(ctx)
+#else
+#define BTN_SNAPSHOT_BEGIN(ctx)
+#define BTN_SNAPSHOT_END(ctx)
+#endif
+#if defined(FLEX_BTN_USING_SNAPSHOT) && !defined(FLEX_BTN_USING_ARRAY_STORAGE)
+#define BTN_SNAPSHOT_SAVE(ctx, btn, i)  flex_button_snapshot_save(ctx, btn, i)
+#else
+#define BTN_SNAPSHOT_SAVE(ctx, btn, i)
+#endif
+
+/**
+ * BTN_TARGET, BTN_STATUS, BTN_EVENT, BTN_SCAN_CNT, BTN_CLICK_CNT
+ * 
+ * The button at index i and its scan state.
+ * With FLEX_BTN_USING_ARRAY_STORAGE the scan state is kept in the context
+ * tables, and BTN_SYNC copies 'event' and 'click_cnt' back to the button
+ * only before its callback is called. The other readers use the tables,
+ * see flex_button_ctx_event_read.
+*/
+#ifdef FLEX_BTN_USING_ARRAY_STORAGE
+#define BTN_TARGET(ctx, i)          (&(ctx)->btn_array[i])
+#define BTN_STATUS(ctx, btn, i)     ((ctx)->btn_status[i])
+#define BTN_EVENT(ctx, btn, i)      ((ctx)->btn_event[i])
+#define BTN_SCAN_CNT(ctx, btn, i)   ((ctx)->btn_scan_cnt[i])
+#define BTN_CLICK_CNT(ctx, btn, i)  ((ctx)->btn_click_cnt[i])
+#define BTN_SYNC(ctx, btn, i)                                                  \
+    do                                                                         \
+    {                                                                          \
+        (btn)->event = (ctx)->btn_event[i];                                    \
+        (btn)->click_cnt = (ctx)->btn_click_cnt[i];                            \
+    } while(0)
+#else
+#ifdef FLEX_BTN_USING_BTN_TABLE
+#define BTN_TARGET(ctx, i)          ((ctx)->btn_table[i])
+#endif
+#define BTN_STATUS(ctx, btn, i)     ((btn)->status)
+#define BTN_EVENT(ctx, btn, i)      ((btn)->event)
+#define BTN_SCAN_CNT(ctx, btn, i)   ((btn)->scan_cnt)
+#define BTN_CLICK_CNT(ctx, btn, i)  ((btn)->click_cnt)
+#define BTN_SYNC(ctx, btn, i)
+#endif
+
+/**
+ * BTN_WALK_START, BTN_WALK_TO
+ * 
+ * Visit the buttons from the highest index down, 'target' is the button at
+ * index i after BTN_WALK_TO. Without a button table, the button list is in
+ * this order, and is walked forward once for all the visited buttons.
+*/
+#if defined(FLEX_BTN_USING_ARRAY_STORAGE) || defined(FLEX_BTN_USING_BTN_TABLE)
+#define BTN_WALK_START(ctx, target, at)  ((void)(at))
+#define BTN_WALK_TO(ctx, target, at, i)  ((target) = BTN_TARGET(ctx, i))
+#else
+#define BTN_WALK_START(ctx, target, at)                                        \
     do                                                                         \
     {                                                                          \
-        btn->event = evt;                                                      \
-        if(btn->cb)                                                            \
-            btn->cb((flex_button_t*)btn);                                      \
+        (target) = (ctx)->btn_head;                                            \
+        (at) = (ctx)->button_cnt - 1;                                          \
     } while(0)
+#define BTN_WALK_TO(ctx, target, at, i)                                        \
+    do                                                                         \
+    {                                                                          \
+        while ((at) > (i))                                                     \
+        {                                                                      \
+            (target) = (target)->next;                                         \
+            (at) --;                                                           \
+        }                                                                      \
+    } while(0)
+#endif
+
+/**
+ * BTN_SLOTS
+ * 
+ * Number of button indexes in use, registered or not.
+*/
+#ifdef FLEX_BTN_USING_ARRAY_STORAGE
+#define BTN_SLOTS(ctx) ((ctx)->array_num)
+#elif defined(FLEX_BTN_USING_UNREGISTER)
+#define BTN_SLOTS(ctx) ((ctx)->slot_num)
+#else
+#define BTN_SLOTS(ctx) ((ctx)->button_cnt)
+#endif
+
+/**
+ * BTN_ENABLE
+ * 
+ * The buttons that are read, registered and not disabled.
+*/
+#ifdef FLEX_BTN_USING_UNREGISTER
+#define BTN_ENABLE(ctx) ((ctx)->enable)
+#else
+#define BTN_ENABLE(ctx) ((ctx)->mask)
+#endif
 
 /**
  * BTN_IS_PRESSED
@@ -48,278 +271,2961 @@
  * 1: is pressed
  * 0: is not pressed
 */
-#define BTN_IS_PRESSED(i) (g_btn_status_reg & (1 << i))
+#define BTN_IS_PRESSED(ctx, i) ((ctx)->status_reg[BTN_WORD(i)] & BTN_BIT(i))
 
-enum FLEX_BTN_STAGE
-{
-    FLEX_BTN_STAGE_DEFAULT = 0,
-    FLEX_BTN_STAGE_DOWN    = 1,
-    FLEX_BTN_STAGE_MULTIPLE_CLICK = 2
-};
+/**
+ * BTN_WORD, BTN_BIT
+ * 
+ * Status word and bit mask of the button at index i.
+*/
+#define BTN_WORD(i) ((i) / FLEX_BTN_WORD_BITS)
+#define BTN_BIT(i)  ((btn_type_t)1 << ((i) % FLEX_BTN_WORD_BITS))
 
-typedef uint32_t btn_type_t;
+/**
+ * FLEX_BTN_MSB
+ * 
+ * Index of the highest set bit, x must not be 0.
+*/
+#if defined(__GNUC__) || defined(__clang__)
+#define FLEX_BTN_MSB(x) ((uint8_t)(sizeof(unsigned long) * 8 - 1 - __builtin_clzl(x)))
+#else
+#define FLEX_BTN_MSB(x) flex_button_msb(x)
+#endif
 
-static flex_button_t *btn_head = NULL;
+#if defined(FLEX_BTN_USING_TIMESTAMP) || defined(FLEX_BTN_USING_TICKLESS)
+/* Milliseconds per scan count */
+#ifdef FLEX_BTN_USING_TIMESTAMP
+#define FLEX_BTN_MS_PER_CNT 1
+#else
+#define FLEX_BTN_MS_PER_CNT (1000 / FLEX_BTN_SCAN_FREQ_HZ)
+#endif
+#endif
 
+#if defined(FLEX_BTN_USING_EVENT_QUEUE) || defined(FLEX_BTN_USING_SNAPSHOT) || \
+    defined(FLEX_BTN_USING_TICKLESS)
 /**
- * g_logic_level
- * 
- * The logic level of the button pressed, 
- * Each bit represents a button.
+ * FLEX_BTN_MEMORY_BARRIER
  * 
- * First registered button, the logic level of the button pressed is 
- * at the low bit of g_logic_level.
+ * Orders the record and the queue index accesses, and the scan state and
+ * snapshot sequence accesses, between the scan and the application thread
+ * or the interrupt.
+ * Define it for the target, e.g. __DMB() on multi-core MCU.
 */
-btn_type_t g_logic_level = (btn_type_t)0;
+#ifndef FLEX_BTN_MEMORY_BARRIER
+#if defined(__GNUC__) || defined(__clang__)
+#define FLEX_BTN_MEMORY_BARRIER() __sync_synchronize()
+#else
+#define FLEX_BTN_MEMORY_BARRIER()
+#endif
+#endif
+#endif
+
+#ifdef FLEX_BTN_USING_EVENT_QUEUE
+#if (FLEX_BTN_EVENT_QUEUE_SIZE & (FLEX_BTN_EVENT_QUEUE_SIZE - 1)) != 0
+#error "FLEX_BTN_EVENT_QUEUE_SIZE must be a power of 2"
+#endif
 
 /**
- * g_btn_status_reg
- * 
- * The status register of all button, each bit records the pressing state of a button.
+ * FLEX_BTN_NOW
  * 
- * First registered button, the pressing state of the button is 
- * at the low bit of g_btn_status_reg.
+ * Timestamp of the queued events.
 */
-btn_type_t g_btn_status_reg = (btn_type_t)0;
+#if !defined(FLEX_BTN_USING_TIMESTAMP) && !defined(FLEX_BTN_USING_TICKLESS)
+#define FLEX_BTN_NOW(ctx) ((ctx)->scan_total)
+#else
+#define FLEX_BTN_NOW(ctx) ((ctx)->last_ts)
+#endif
+#endif
 
-static uint8_t button_cnt = 0;
+#ifdef FLEX_BTN_USING_TICKLESS
+#if (FLEX_BTN_EDGE_QUEUE_SIZE & (FLEX_BTN_EDGE_QUEUE_SIZE - 1)) != 0
+#error "FLEX_BTN_EDGE_QUEUE_SIZE must be a power of 2"
+#endif
+#endif
 
 /**
- * @brief Register a user button
+ * g_btn_ctx
  * 
- * @param button: button structure instance
- * @return Number of keys that have been registered, or -1 when error
+ * The default context, used by the API without 'ctx'.
 */
-int32_t flex_button_register(flex_button_t *button)
+static flex_button_ctx_t g_btn_ctx;
+
+#if !defined(__GNUC__) && !defined(__clang__)
+static uint8_t flex_button_msb(btn_type_t x)
 {
-    flex_button_t *curr = btn_head;
-    
-    if (!button || (button_cnt > sizeof(btn_type_t) * 8))
+    uint8_t i = 0;
+
+    while (x >>= 1)
     {
-        return -1;
+        i ++;
     }
 
-    while (curr)
+    return i;
+}
+#endif
+
+#ifdef FLEX_BTN_USING_EVENT_QUEUE
+/**
+ * @brief Queue an event, drop it when the queue is full.
+ * 
+ * @param ctx: button context
+ * @param id: button id, or combination or encoder id
+ * @param event: the event
+ * @param click_cnt: click count of the button, or the count of the event
+ * @param velocity: encoder velocity, only for FLEX_BTN_PRESS_STEP
+ * @return none
+*/
+static void flex_button_event_push(flex_button_ctx_t *ctx, uint8_t id, uint8_t event,
+    uint16_t click_cnt, int16_t velocity)
+{
+    uint16_t head = ctx->event_queue.head;
+    flex_button_event_record_t *record;
+
+    if ((uint16_t)(head - ctx->event_queue.tail) >= FLEX_BTN_EVENT_QUEUE_SIZE)
     {
-        if(curr == button)
-        {
-            return -1;  /* already exist. */
-        }
-        curr = curr->next;
+        ctx->event_queue.overflow ++;
+        return;
     }
 
-    /**
-     * First registered button is at the end of the 'linked list'.
-     * btn_head points to the head of the 'linked list'.
-    */
-    button->next = btn_head;
-    button->status = FLEX_BTN_STAGE_DEFAULT;
-    button->event = FLEX_BTN_PRESS_NONE;
-    button->scan_cnt = 0;
-    button->click_cnt = 0;
-    button->max_multiple_clicks_interval = MAX_MULTIPLE_CLICKS_INTERVAL;
-    btn_head = button;
+    record = &ctx->event_queue.record[head & (FLEX_BTN_EVENT_QUEUE_SIZE - 1)];
+    record->id = id;
+    record->event = event;
+    record->click_cnt = click_cnt;
+    record->timestamp = FLEX_BTN_NOW(ctx);
+#ifdef FLEX_BTN_USING_ENCODER
+    record->velocity = velocity;
+#else
+    (void)velocity;
+#endif
 
-    /**
-     * First registered button, the logic level of the button pressed is 
-     * at the low bit of g_logic_level.
-    */
-    g_logic_level |= (button->pressed_logic_level << button_cnt);
-    button_cnt ++;
+    /* The record must be written before it is published */
+    FLEX_BTN_MEMORY_BARRIER();
+    ctx->event_queue.head = head + 1;
+}
+#endif
+
+#ifdef FLEX_BTN_USING_STATS
+static void flex_button_stats_event(flex_button_ctx_t *ctx, uint8_t event, uint32_t latency)
+{
+    uint8_t bin = 0;
 
-    return button_cnt;
+    if (event < FLEX_BTN_PRESS_MAX)
+    {
+        ctx->stats.event_cnt[event] ++;
+    }
+
+    /* bin k counts the latencies of 2^(k-1) to 2^k - 1 */
+    while (latency && (bin < FLEX_BTN_STATS_LATENCY_BINS - 1))
+    {
+        bin ++;
+        latency >>= 1;
+    }
+    ctx->stats.latency_hist[bin] ++;
 }
 
 /**
- * @brief Read all key values in one scan cycle
+ * @brief Record the sampled level changes, before debouncing.
  * 
- * @param void
+ * @param ctx: button context
+ * @param pressed: the sampled pressing state, FLEX_BTN_STATUS_WORDS words
  * @return none
 */
-static void flex_button_read(void)
+static void flex_button_stats_sample(flex_button_ctx_t *ctx, const btn_type_t *pressed)
 {
-    uint8_t i;
-    flex_button_t* target;
-
-    /* The button that was registered first, the button value is in the low position of raw_data */
-    btn_type_t raw_data = 0;
+    uint8_t w;
 
-    for(target = btn_head, i = button_cnt - 1;
-        (target != NULL) && (target->usr_button_read != NULL);
-        target = target->next, i--)
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
     {
-        raw_data = raw_data | ((target->usr_button_read)(target) << i);
+        ctx->stats_changed[w] |= pressed[w] ^ ctx->stats_raw[w];
+        ctx->stats_raw[w] = pressed[w];
     }
-
-    g_btn_status_reg = (~raw_data) ^ g_logic_level;
 }
 
 /**
- * @brief Handle all key events in one scan cycle.
- *        Must be used after 'flex_button_read' API
+ * @brief Count the scan cycles of a process, and take its time as the time
+ *        of the level changes sampled for it.
  * 
- * @param void
- * @return Activated button count
+ * @param ctx: button context
+ * @param elapsed: scan cycles since the last process
+ * @return none
 */
-static uint8_t flex_button_process(void)
+static void flex_button_stats_process(flex_button_ctx_t *ctx, uint16_t elapsed)
 {
-    uint8_t i;
-    uint8_t active_btn_cnt = 0;
-    flex_button_t* target;
-    
-    for (target = btn_head, i = button_cnt - 1; target != NULL; target = target->next, i--)
+    btn_type_t changed;
+    btn_index_t i;
+    uint8_t w;
+
+    ctx->stats_clock += elapsed;
+
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
     {
-        if (target->status > FLEX_BTN_STAGE_DEFAULT)
+        changed = ctx->stats_changed[w];
+        ctx->stats_changed[w] = 0;
+
+        while (changed)
         {
-            target->scan_cnt ++;
-            if (target->scan_cnt >= ((1 << (sizeof(target->scan_cnt) * 8)) - 1))
-            {
-                target->scan_cnt = target->long_hold_start_tick;
-            }
+            i = FLEX_BTN_MSB(changed);
+            changed &= ~((btn_type_t)1 << i);
+            ctx->stats_edge[i + w * FLEX_BTN_WORD_BITS] = ctx->stats_clock;
         }
+    }
+}
 
-        switch (target->status)
-        {
-        case FLEX_BTN_STAGE_DEFAULT: /* stage: default(button up) */
-            if (BTN_IS_PRESSED(i)) /* is pressed */
-            {
-                target->scan_cnt = 0;
-                target->click_cnt = 0;
+#ifndef FLEX_BTN_USING_EVENT_QUEUE
+static void flex_button_stats_cb(flex_button_ctx_t *ctx, uint32_t cycles)
+{
+    ctx->stats.cb_cnt ++;
+    ctx->stats.cb_cycles_total += cycles;
+    if (cycles > ctx->stats.cb_cycles_max)
+    {
+        ctx->stats.cb_cycles_max = cycles;
+    }
+}
+#endif
 
-                EVENT_SET_AND_EXEC_CB(target, FLEX_BTN_PRESS_DOWN);
+static uint8_t flex_button_stats_scan(flex_button_ctx_t *ctx, uint8_t active)
+{
+    uint32_t cycles = FLEX_BTN_CYCLES() - ctx->scan_start;
 
-                /* swtich to button down stage */
-                target->status = FLEX_BTN_STAGE_DOWN;
-            }
-            else
-            {
-                target->event = FLEX_BTN_PRESS_NONE;
-            }
-            break;
+    ctx->stats.scan_cnt ++;
+    ctx->scan_cycles_sum += cycles;
+    if (cycles > ctx->stats.scan_cycles_max)
+    {
+        ctx->stats.scan_cycles_max = cycles;
+    }
 
-        case FLEX_BTN_STAGE_DOWN: /* stage: button down */
-            if (BTN_IS_PRESSED(i)) /* is pressed */
-            {
-                if (target->click_cnt > 0) /* multiple click */
-                {
-                    if (target->scan_cnt > target->max_multiple_clicks_interval)
-                    {
-                        EVENT_SET_AND_EXEC_CB(target, 
-                            target->click_cnt < FLEX_BTN_PRESS_REPEAT_CLICK ? 
-                                target->click_cnt :
-                                FLEX_BTN_PRESS_REPEAT_CLICK);
+    return active;
+}
+#endif
 
-                        /* swtich to button down stage */
-                        target->status = FLEX_BTN_STAGE_DOWN;
-                        target->scan_cnt = 0;
-                        target->click_cnt = 0;
-                    }
-                }
-                else if (target->scan_cnt >= target->long_hold_start_tick)
-                {
-                    if (target->event != FLEX_BTN_PRESS_LONG_HOLD)
-                    {
-                        EVENT_SET_AND_EXEC_CB(target, FLEX_BTN_PRESS_LONG_HOLD);
-                    }
-                }
-                else if (target->scan_cnt >= target->long_press_start_tick)
-                {
-                    if (target->event != FLEX_BTN_PRESS_LONG_START)
-                    {
-                        EVENT_SET_AND_EXEC_CB(target, FLEX_BTN_PRESS_LONG_START);
-                    }
-                }
-                else if (target->scan_cnt >= target->short_press_start_tick)
-                {
-                    if (target->event != FLEX_BTN_PRESS_SHORT_START)
-                    {
-                        EVENT_SET_AND_EXEC_CB(target, FLEX_BTN_PRESS_SHORT_START);
-                    }
-                }
-            }
-            else /* button up */
-            {
-                if (target->scan_cnt >= target->long_hold_start_tick)
-                {
-                    EVENT_SET_AND_EXEC_CB(target, FLEX_BTN_PRESS_LONG_HOLD_UP);
-                    target->status = FLEX_BTN_STAGE_DEFAULT;
-                }
-                else if (target->scan_cnt >= target->long_press_start_tick)
-                {
-                    EVENT_SET_AND_EXEC_CB(target, FLEX_BTN_PRESS_LONG_UP);
-                    target->status = FLEX_BTN_STAGE_DEFAULT;
-                }
-                else if (target->scan_cnt >= target->short_press_start_tick)
-                {
-                    EVENT_SET_AND_EXEC_CB(target, FLEX_BTN_PRESS_SHORT_UP);
-                    target->status = FLEX_BTN_STAGE_DEFAULT;
-                }
-                else
-                {
-                    /* swtich to multiple click stage */
-                    target->status = FLEX_BTN_STAGE_MULTIPLE_CLICK;
-                    target->click_cnt ++;
-                }
-            }
-            break;
+#ifdef FLEX_BTN_USING_EVENT_BATCH
+/**
+ * @brief Pass the collected events to the batch handler, skipped when there are none.
+ * 
+ * @param ctx: button context
+ * @return none
+*/
+static void flex_button_batch_flush(flex_button_ctx_t *ctx)
+{
+    if ((ctx->batch_num > 0) && ctx->batch_handler)
+    {
+        BTN_STATS_CB_BEGIN(ctx);
+        ctx->batch_handler(ctx->batch_arg, ctx->batch, ctx->batch_num);
+        BTN_STATS_CB_END(ctx);
+    }
+    ctx->batch_num = 0;
+}
 
-        case FLEX_BTN_STAGE_MULTIPLE_CLICK: /* stage: multiple click */
-            if (BTN_IS_PRESSED(i)) /* is pressed */
-            {
-                /* swtich to button down stage */
-                target->status = FLEX_BTN_STAGE_DOWN;
-                target->scan_cnt = 0;
-            }
-            else
-            {
-                if (target->scan_cnt > target->max_multiple_clicks_interval)
-                {
-                    EVENT_SET_AND_EXEC_CB(target, 
-                        target->click_cnt < FLEX_BTN_PRESS_REPEAT_CLICK ? 
-                            target->click_cnt :
-                            FLEX_BTN_PRESS_REPEAT_CLICK);
+/**
+ * @brief Collect an event of the scan, pass the collected events to the batch
+ *        handler first when the array is full.
+ * 
+ * @param ctx: button context
+ * @param id: button id, or combination or encoder id
+ * @param event: the event
+ * @param click_cnt: click count of the button, or the count of the event
+ * @param velocity: encoder velocity, only for FLEX_BTN_PRESS_STEP
+ * @return none
+*/
+static void flex_button_event_push(flex_button_ctx_t *ctx, uint8_t id, uint8_t event,
+    uint16_t click_cnt, int16_t velocity)
+{
+    flex_button_batch_event_t *batch;
 
-                    /* swtich to default stage */
-                    target->status = FLEX_BTN_STAGE_DEFAULT;
-                }
-            }
-            break;
-        }
-        
-        if (target->status > FLEX_BTN_STAGE_DEFAULT)
-        {
-            active_btn_cnt ++;
-        }
+    if (ctx->batch_num >= FLEX_BTN_EVENT_BATCH_SIZE)
+    {
+        flex_button_batch_flush(ctx);
     }
-    
-    return active_btn_cnt;
+
+    batch = &ctx->batch[ctx->batch_num ++];
+    batch->id = id;
+    batch->event = event;
+    batch->click_cnt = click_cnt;
+#ifdef FLEX_BTN_USING_ENCODER
+    batch->velocity = velocity;
+#else
+    (void)velocity;
+#endif
 }
 
 /**
- * flex_button_event_read
+ * @brief End of the scan, pass the collected events to the batch handler.
  * 
- * @brief Get the button event of the specified button.
+ * @param ctx: button context
+ * @param active: activated button count of the scan
+ * @return 'active'
+*/
+static uint8_t flex_button_batch_end(flex_button_ctx_t *ctx, uint8_t active)
+{
+    flex_button_batch_flush(ctx);
+    ctx->batch = NULL;
+
+    return active;
+}
+#endif
+
+#ifdef FLEX_BTN_USING_SNAPSHOT
+/**
+ * @brief Start changing the scan state, the snapshots taken until
+ *        flex_button_snapshot_end are retried.
  * 
- * @param button: button structure instance
- * @return button event
+ * @param ctx: button context
+ * @return none
 */
-flex_button_event_t flex_button_event_read(flex_button_t* button)
+static void flex_button_snapshot_begin(flex_button_ctx_t *ctx)
 {
-    return (flex_button_event_t)(button->event);
+    ctx->snapshot_seq ++;
+
+    /* The sequence must be odd before the state changes */
+    FLEX_BTN_MEMORY_BARRIER();
 }
 
 /**
- * flex_button_scan
+ * @brief End of the changes of the scan state.
  * 
- * @brief Start key scan.
- *        Need to be called cyclically within the specified period.
- *        Sample cycle: 5 - 20ms
+ * @param ctx: button context
+ * @return none
+*/
+static void flex_button_snapshot_end(flex_button_ctx_t *ctx)
+{
+    /* The state must be changed before the sequence is even again */
+    FLEX_BTN_MEMORY_BARRIER();
+    ctx->snapshot_seq ++;
+}
+
+#ifndef FLEX_BTN_USING_ARRAY_STORAGE
+/**
+ * @brief Copy the scan state of a button to 'snapshot_button',
+ *        between flex_button_snapshot_begin and flex_button_snapshot_end.
  * 
- * @param void
- * @return Activated button count
+ * @param ctx: button context
+ * @param button: button structure instance
+ * @param i: button index
+ * @return none
 */
-uint8_t flex_button_scan(void)
+static void flex_button_snapshot_save(flex_button_ctx_t *ctx, flex_button_t *button, btn_index_t i)
 {
-    flex_button_read();
-    return flex_button_process();
+    flex_button_snapshot_button_t *copy = &ctx->snapshot_button[i];
+
+    copy->scan_cnt = button->scan_cnt;
+    copy->click_cnt = button->click_cnt;
+    copy->id = button->id;
+    copy->event = button->event;
+    copy->status = button->status;
 }
+#endif
+#endif
+
+/**
+ * flex_button_ctx_init
+ * 
+ * @brief Initialize a button context.
+ *        Not needed for a zero-initialized context, e.g. a static variable.
+ * 
+ * @param ctx: button context
+ * @return none
+*/
+void flex_button_ctx_init(flex_button_ctx_t *ctx)
+{
+    uint8_t *p = (uint8_t *)ctx;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(flex_button_ctx_t); i ++)
+    {
+        p[i] = 0;
+    }
+}
+
+#ifdef FLEX_BTN_USING_ARRAY_STORAGE
+/**
+ * flex_button_ctx_array_init
+ * 
+ * @brief Set the button array of the context, before registering the buttons.
+ *        The bit index of each button is its position in the array.
+ * 
+ * @param ctx: button context
+ * @param buttons: button array
+ * @param num: number of buttons in the array, up to FLEX_BTN_MAX_NUM
+ * @return 0 on success, -1 when error
+*/
+int32_t flex_button_ctx_array_init(flex_button_ctx_t *ctx, flex_button_t *buttons, uint16_t num)
+{
+    if (!buttons || (num > FLEX_BTN_MAX_NUM) || (ctx->button_cnt > 0))
+    {
+        return -1;
+    }
+
+    ctx->btn_array = buttons;
+    ctx->array_num = (btn_index_t)num;
+
+    return 0;
+}
+#endif
+
+/**
+ * @brief Reset the scan state of a button, it restarts released and idle.
+ * 
+ * @param ctx: button context
+ * @param button: button structure instance
+ * @param i: button index
+ * @return none
+*/
+static void flex_button_state_reset(flex_button_ctx_t *ctx, flex_button_t *button, btn_index_t i)
+{
+    (void)button;
+
+    BTN_STATUS(ctx, button, i) = FLEX_BTN_STAGE_DEFAULT;
+    BTN_EVENT(ctx, button, i) = FLEX_BTN_PRESS_NONE;
+    BTN_SCAN_CNT(ctx, button, i) = 0;
+    BTN_CLICK_CNT(ctx, button, i) = 0;
+#ifdef FLEX_BTN_USING_REPEAT
+    button->repeat_cnt = 0;
+    button->repeat_wait = 0;
+#endif
+
+    BTN_SNAPSHOT_SAVE(ctx, button, i);
+
+    ctx->status_reg[BTN_WORD(i)] &= ~BTN_BIT(i);
+    ctx->active_reg[BTN_WORD(i)] &= ~BTN_BIT(i);
+#ifdef FLEX_BTN_USING_DEBOUNCE
+    {
+        uint8_t k;
+
+        for (k = 0; k < FLEX_BTN_DEBOUNCE_CNT_BITS; k ++)
+        {
+            ctx->debounce_cnt[BTN_WORD(i)][k] &= ~BTN_BIT(i);
+        }
+    }
+#endif
+#ifdef FLEX_BTN_USING_COMBO
+    ctx->combo_suppress[BTN_WORD(i)] &= ~BTN_BIT(i);
+    ctx->combo_hold[BTN_WORD(i)] &= ~BTN_BIT(i);
+    ctx->combo_held[i] = 0;
+#endif
+}
+
+#if defined(FLEX_BTN_USING_ARRAY_STORAGE) || defined(FLEX_BTN_USING_UNREGISTER)
+/**
+ * @brief Get the bit index of a registered button.
+ * 
+ * @param ctx: button context
+ * @param button: button structure instance
+ * @return The bit index, or -1 when the button is not registered
+*/
+static int32_t flex_button_index(flex_button_ctx_t *ctx, flex_button_t *button)
+{
+    btn_index_t i;
+
+#ifdef FLEX_BTN_USING_ARRAY_STORAGE
+    if (!button || !ctx->btn_array ||
+        (button < ctx->btn_array) || (button >= ctx->btn_array + ctx->array_num))
+    {
+        return -1;
+    }
+
+    i = (btn_index_t)(button - ctx->btn_array);
+    if (ctx->mask[BTN_WORD(i)] & BTN_BIT(i))
+    {
+        return i;
+    }
+#else
+    for (i = 0; i < ctx->slot_num; i ++)
+    {
+        if ((ctx->btn_table[i] == button) && (ctx->mask[BTN_WORD(i)] & BTN_BIT(i)))
+        {
+            return i;
+        }
+    }
+#endif
+
+    return -1;
+}
+#endif
+
+/**
+ * @brief Register a user button
+ *        With FLEX_BTN_USING_ARRAY_STORAGE, the button must be in the array
+ *        set by 'flex_button_ctx_array_init'.
+ * 
+ * @param ctx: button context
+ * @param button: button structure instance
+ * @return Number of keys that have been registered, or -1 when error
+*/
+int32_t flex_button_ctx_register(flex_button_ctx_t *ctx, flex_button_t *button)
+{
+#ifdef FLEX_BTN_USING_ARRAY_STORAGE
+    btn_index_t i;
+
+    if (!button || !ctx->btn_array ||
+        (button < ctx->btn_array) || (button >= ctx->btn_array + ctx->array_num))
+    {
+        return -1;  /* not in the button array. */
+    }
+
+    /* The bit index is the position in the array */
+    i = (btn_index_t)(button - ctx->btn_array);
+    if (ctx->mask[BTN_WORD(i)] & BTN_BIT(i))
+    {
+        return -1;  /* already exist. */
+    }
+#else
+    btn_index_t i = ctx->button_cnt;
+    flex_button_t *curr = ctx->btn_head;
+    
+    if (!button || (ctx->button_cnt >= FLEX_BTN_MAX_NUM))
+    {
+        return -1;
+    }
+
+    while (curr)
+    {
+        if(curr == button)
+        {
+            return -1;  /* already exist. */
+        }
+        curr = curr->next;
+    }
+
+#ifdef FLEX_BTN_USING_UNREGISTER
+    /* The lowest free bit index, the bits of the other buttons never move */
+    for (i = 0; i < ctx->slot_num; i ++)
+    {
+        if (!(ctx->mask[BTN_WORD(i)] & BTN_BIT(i)))
+        {
+            break;
+        }
+    }
+#endif
+#endif
+
+#ifdef FLEX_BTN_USING_RULE_TABLE
+    if (!ctx->rules) /* built-in gestures by default */
+    {
+        flex_button_ctx_rules_set(ctx, NULL, 0);
+    }
+#endif
+
+#ifdef FLEX_BTN_USING_GROUP_READ
+    if (button->group)
+    {
+        flex_button_group_t *group = ctx->group_head;
+
+        while (group && (group != button->group))
+        {
+            group = group->next;
+        }
+
+        if (!group || (button->group_bit >= sizeof(btn_type_t) * 8))
+        {
+            return -1;  /* group not registered or invalid bit. */
+        }
+    }
+#endif
+
+    BTN_SNAPSHOT_BEGIN(ctx);
+#ifndef FLEX_BTN_USING_ARRAY_STORAGE
+    /**
+     * First registered button is at the end of the 'linked list'.
+     * btn_head points to the head of the 'linked list'.
+    */
+    button->next = ctx->btn_head;
+    ctx->btn_head = button;
+#ifdef FLEX_BTN_USING_BTN_TABLE
+    ctx->btn_table[i] = button;
+#endif
+#ifdef FLEX_BTN_USING_UNREGISTER
+    if (i >= ctx->slot_num)
+    {
+        ctx->slot_num = i + 1;
+    }
+#endif
+#endif
+    flex_button_state_reset(ctx, button, i);
+    button->max_multiple_clicks_interval = MAX_MULTIPLE_CLICKS_INTERVAL;
+
+    /**
+     * First registered button, the logic level of the button pressed is 
+     * at the low bit of logic_level.
+    */
+    if (button->pressed_logic_level)
+    {
+        ctx->logic_level[BTN_WORD(i)] |= BTN_BIT(i);
+    }
+    ctx->mask[BTN_WORD(i)] |= BTN_BIT(i);
+#ifdef FLEX_BTN_USING_UNREGISTER
+    ctx->enable[BTN_WORD(i)] |= BTN_BIT(i);
+#endif
+#ifdef FLEX_BTN_USING_DEBOUNCE
+    {
+        uint8_t k;
+        uint16_t tick = button->debounce_tick;
+
+        if (tick < 1)
+        {
+            tick = 1;  /* state follows the raw value in the next scan */
+        }
+        else if (tick > (1 << FLEX_BTN_DEBOUNCE_CNT_BITS) - 1)
+        {
+            tick = (1 << FLEX_BTN_DEBOUNCE_CNT_BITS) - 1;
+        }
+
+        for (k = 0; k < FLEX_BTN_DEBOUNCE_CNT_BITS; k ++)
+        {
+            if ((tick >> k) & 1)
+            {
+                ctx->debounce_tick[BTN_WORD(i)][k] |= BTN_BIT(i);
+            }
+        }
+    }
+#endif
+#ifdef FLEX_BTN_USING_TICKLESS
+    /* Released until flex_button_notify_edge reports otherwise */
+    if (!button->pressed_logic_level)
+    {
+        ctx->raw_reg[BTN_WORD(i)] |= BTN_BIT(i);
+        ctx->edge_level[BTN_WORD(i)] |= BTN_BIT(i);
+    }
+#endif
+    ctx->button_cnt ++;
+    BTN_SNAPSHOT_END(ctx);
+
+    return ctx->button_cnt;
+}
+
+#ifdef FLEX_BTN_USING_UNREGISTER
+/**
+ * @brief Unregister a user button
+ *        The bit index of the other buttons does not change, the index of this
+ *        button is free for the next registered button.
+ *        Combinations with this button are not reported any more.
+ * 
+ * @param ctx: button context
+ * @param button: button structure instance
+ * @return Number of keys still registered, or -1 when the button is not registered
+*/
+int32_t flex_button_ctx_unregister(flex_button_ctx_t *ctx, flex_button_t *button)
+{
+    int32_t index = flex_button_index(ctx, button);
+    btn_index_t i;
+
+    if (index < 0)
+    {
+        return -1;
+    }
+    i = (btn_index_t)index;
+
+    BTN_SNAPSHOT_BEGIN(ctx);
+    flex_button_state_reset(ctx, button, i);
+    ctx->mask[BTN_WORD(i)] &= ~BTN_BIT(i);
+    ctx->enable[BTN_WORD(i)] &= ~BTN_BIT(i);
+    ctx->logic_level[BTN_WORD(i)] &= ~BTN_BIT(i);
+#ifdef FLEX_BTN_USING_DEBOUNCE
+    {
+        uint8_t k;
+
+        for (k = 0; k < FLEX_BTN_DEBOUNCE_CNT_BITS; k ++)
+        {
+            ctx->debounce_tick[BTN_WORD(i)][k] &= ~BTN_BIT(i);
+        }
+    }
+#endif
+#ifdef FLEX_BTN_USING_TICKLESS
+    ctx->raw_reg[BTN_WORD(i)] &= ~BTN_BIT(i);
+    ctx->edge_level[BTN_WORD(i)] &= ~BTN_BIT(i);
+#endif
+
+#ifndef FLEX_BTN_USING_ARRAY_STORAGE
+    {
+        flex_button_t **curr = &ctx->btn_head;
+
+        while (*curr != button)
+        {
+            curr = &(*curr)->next;
+        }
+        *curr = button->next;
+        button->next = NULL;
+    }
+
+    ctx->btn_table[i] = NULL;
+    while ((ctx->slot_num > 0) &&
+           !(ctx->mask[BTN_WORD(ctx->slot_num - 1)] & BTN_BIT(ctx->slot_num - 1)))
+    {
+        ctx->slot_num --;
+    }
+#endif
+    ctx->button_cnt --;
+    BTN_SNAPSHOT_END(ctx);
+
+    return ctx->button_cnt;
+}
+
+/**
+ * @brief Enable or disable a user button
+ *        A disabled button is not read, not pressed and not handled by the scan.
+ *        Its gesture in progress is dropped without events, and it restarts
+ *        released when enabled again.
+ * 
+ * @param ctx: button context
+ * @param button: button structure instance
+ * @param enable: 1 to enable, 0 to disable
+ * @return 0 on success, -1 when the button is not registered
+*/
+int32_t flex_button_ctx_enable(flex_button_ctx_t *ctx, flex_button_t *button, uint8_t enable)
+{
+    int32_t index = flex_button_index(ctx, button);
+    btn_index_t i;
+
+    if (index < 0)
+    {
+        return -1;
+    }
+    i = (btn_index_t)index;
+
+    BTN_SNAPSHOT_BEGIN(ctx);
+    if (enable)
+    {
+        ctx->enable[BTN_WORD(i)] |= BTN_BIT(i);
+    }
+    else if (ctx->enable[BTN_WORD(i)] & BTN_BIT(i))
+    {
+        ctx->enable[BTN_WORD(i)] &= ~BTN_BIT(i);
+        flex_button_state_reset(ctx, button, i);
+    }
+    BTN_SNAPSHOT_END(ctx);
+
+    return 0;
+}
+
+/**
+ * @brief Set the enabled buttons at once, e.g. the keys of a UI mode.
+ *        Same as flex_button_ctx_enable of each button.
+ * 
+ * @param ctx: button context
+ * @param enable: enabled buttons, bit i is the button at bit i of 'status_reg',
+ *        FLEX_BTN_STATUS_WORDS words. Bits of unregistered buttons are ignored.
+ * @return none
+*/
+void flex_button_ctx_enable_mask(flex_button_ctx_t *ctx, const btn_type_t *enable)
+{
+    btn_index_t i;
+    uint8_t w;
+    btn_type_t off;
+
+    BTN_SNAPSHOT_BEGIN(ctx);
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        off = ctx->enable[w] & ~enable[w];
+        ctx->enable[w] = enable[w] & ctx->mask[w];
+
+        while (off)
+        {
+            i = FLEX_BTN_MSB(off);
+            off &= ~((btn_type_t)1 << i);
+            i += w * FLEX_BTN_WORD_BITS;
+            flex_button_state_reset(ctx, BTN_TARGET(ctx, i), i);
+        }
+    }
+    BTN_SNAPSHOT_END(ctx);
+}
+#endif
+
+#ifdef FLEX_BTN_USING_GROUP_READ
+/**
+ * @brief Register a user button group
+ *        Must be registered before the buttons that use it.
+ * 
+ * @param ctx: button context
+ * @param group: button group structure instance
+ * @return Number of groups that have been registered, or -1 when error
+*/
+int32_t flex_button_ctx_group_register(flex_button_ctx_t *ctx, flex_button_group_t *group)
+{
+    int32_t group_cnt = 0;
+    flex_button_group_t *curr = ctx->group_head;
+
+    if (!group || !group->usr_group_read)
+    {
+        return -1;
+    }
+
+    while (curr)
+    {
+        if(curr == group)
+        {
+            return -1;  /* already exist. */
+        }
+        curr = curr->next;
+        group_cnt ++;
+    }
+
+    group->next = ctx->group_head;
+    group->value = 0;
+    ctx->group_head = group;
+
+    return group_cnt + 1;
+}
+#endif
+
+#ifdef FLEX_BTN_USING_COMBO
+/**
+ * @brief Register a button combination
+ *        Must be registered after the buttons that it uses.
+ * 
+ * @param ctx: button context
+ * @param combo: combination structure instance
+ * @return Number of combinations that have been registered, or -1 when error
+*/
+int32_t flex_button_ctx_combo_register(flex_button_ctx_t *ctx, flex_button_combo_t *combo)
+{
+    flex_button_combo_t *curr = ctx->combo_head;
+    int32_t combo_cnt = 0;
+    uint16_t k;
+    uint8_t w;
+
+    if (!combo || !combo->steps || (combo->step_num == 0) || (combo->step_num == 0xFF))
+    {
+        return -1;
+    }
+
+    for (k = 0; k < combo->step_num; k ++)
+    {
+        btn_type_t any = 0;
+
+        for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+        {
+            if (combo->steps[k * FLEX_BTN_STATUS_WORDS + w] & ~ctx->mask[w])
+            {
+                return -1;  /* button not registered. */
+            }
+            any |= combo->steps[k * FLEX_BTN_STATUS_WORDS + w];
+        }
+
+        if (!any)
+        {
+            return -1;  /* empty step. */
+        }
+    }
+
+    while (curr)
+    {
+        if(curr == combo)
+        {
+            return -1;  /* already exist. */
+        }
+        curr = curr->next;
+        combo_cnt ++;
+    }
+
+    combo->step = 0;
+    combo->cnt = 0;
+    combo->next = ctx->combo_head;
+    ctx->combo_head = combo;
+
+    return combo_cnt + 1;
+}
+#endif
+
+#ifdef FLEX_BTN_USING_ENCODER
+/**
+ * @brief Register a rotary encoder
+ * 
+ * @param ctx: button context
+ * @param encoder: encoder structure instance
+ * @return Number of encoders that have been registered, or -1 when error
+*/
+int32_t flex_button_ctx_encoder_register(flex_button_ctx_t *ctx, flex_button_encoder_t *encoder)
+{
+    flex_button_encoder_t *curr = ctx->encoder_head;
+    int32_t encoder_cnt = 0;
+
+    if (!encoder || !encoder->usr_encoder_read || (encoder->steps_per_detent > 4))
+    {
+        return -1;
+    }
+
+    while (curr)
+    {
+        if(curr == encoder)
+        {
+            return -1;  /* already exist. */
+        }
+        curr = curr->next;
+        encoder_cnt ++;
+    }
+
+    if (encoder->steps_per_detent == 0)
+    {
+        encoder->steps_per_detent = 4;
+    }
+    encoder->phase = encoder->usr_encoder_read(encoder) & 3;
+    encoder->sub_step = 0;
+    encoder->position = 0;
+    encoder->step = 0;
+    encoder->velocity = 0;
+    encoder->cnt = FLEX_MS_TO_SCAN_CNT(1000);
+    encoder->next = ctx->encoder_head;
+    ctx->encoder_head = encoder;
+
+    return encoder_cnt + 1;
+}
+#endif
+
+#ifdef FLEX_BTN_USING_DEBOUNCE
+/**
+ * @brief Debounce all buttons at once.
+ *        A button changes state after its raw state differs from the current
+ *        state in 'debounce_tick' consecutive scans.
+ * 
+ * @param ctx: button context
+ * @param w: status word
+ * @param raw: raw pressing state of the buttons in the word
+ * @return Debounced pressing state of the buttons in the word
+*/
+static btn_type_t flex_button_debounce(flex_button_ctx_t *ctx, uint8_t w, btn_type_t raw)
+{
+    uint8_t k;
+    btn_type_t *cnt = ctx->debounce_cnt[w];
+    btn_type_t *tick = ctx->debounce_tick[w];
+    btn_type_t delta = raw ^ ctx->status_reg[w];
+    btn_type_t carry = delta;
+    btn_type_t match = ~(btn_type_t)0;
+    btn_type_t toggle;
+    btn_type_t t;
+
+    /* Count up where the raw state differs, clear elsewhere */
+    for (k = 0; k < FLEX_BTN_DEBOUNCE_CNT_BITS; k ++)
+    {
+        t = cnt[k] & carry;
+        cnt[k] = (cnt[k] ^ carry) & delta;
+        carry = t;
+        match &= ~(cnt[k] ^ tick[k]);
+    }
+
+    /* Counter reaches debounce_tick, accept the new state */
+    toggle = delta & match;
+    for (k = 0; k < FLEX_BTN_DEBOUNCE_CNT_BITS; k ++)
+    {
+        cnt[k] &= ~toggle;
+    }
+
+    return ctx->status_reg[w] ^ toggle;
+}
+#endif
+
+/**
+ * @brief Update the button status register with the pressing state of one scan
+ * 
+ * @param ctx: button context
+ * @param pressed: pressing state of the registered buttons, FLEX_BTN_STATUS_WORDS words
+ * @return none
+*/
+static void flex_button_sample(flex_button_ctx_t *ctx, const btn_type_t *pressed)
+{
+    uint8_t w;
+
+#ifdef FLEX_BTN_USING_TRACE
+    if (ctx->trace_hook)
+    {
+        ctx->trace_hook(ctx->trace_arg, pressed);
+    }
+#endif
+#ifdef FLEX_BTN_USING_STATS
+    flex_button_stats_sample(ctx, pressed);
+#endif
+
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+#ifdef FLEX_BTN_USING_DEBOUNCE
+        ctx->status_reg[w] = flex_button_debounce(ctx, w, pressed[w]);
+#else
+        ctx->status_reg[w] = pressed[w];
+#endif
+    }
+}
+
+/**
+ * @brief Read all key values in one scan cycle
+ * 
+ * @param ctx: button context
+ * @return none
+*/
+static void flex_button_read(flex_button_ctx_t *ctx)
+{
+    btn_index_t i;
+    btn_index_t at;
+    uint8_t w;
+    flex_button_t* target;
+
+    /* The button that was registered first, the button value is in the low position of raw_data */
+    btn_type_t raw_data[FLEX_BTN_STATUS_WORDS] = { 0 };
+
+#ifdef FLEX_BTN_USING_GROUP_READ
+    flex_button_group_t* group;
+
+    /* One read per group, instead of one read per button */
+    for (group = ctx->group_head; group != NULL; group = group->next)
+    {
+        group->value = (group->usr_group_read)(group);
+    }
+#endif
+
+    BTN_WALK_START(ctx, target, at);
+    for (i = BTN_SLOTS(ctx); i-- > 0; )
+    {
+        if (!(BTN_ENABLE(ctx)[BTN_WORD(i)] & BTN_BIT(i)))
+        {
+            continue; /* not registered or disabled */
+        }
+        BTN_WALK_TO(ctx, target, at, i);
+
+#ifdef FLEX_BTN_USING_GROUP_READ
+        if (target->group != NULL)
+        {
+            raw_data[BTN_WORD(i)] |=
+                ((target->group->value >> target->group_bit) & 1) << (i % FLEX_BTN_WORD_BITS);
+            continue;
+        }
+#endif
+        if (target->usr_button_read == NULL)
+        {
+            break;
+        }
+        raw_data[BTN_WORD(i)] |=
+            (btn_type_t)(target->usr_button_read)(target) << (i % FLEX_BTN_WORD_BITS);
+    }
+
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        raw_data[w] = ((~raw_data[w]) ^ ctx->logic_level[w]) & BTN_ENABLE(ctx)[w];
+    }
+
+    flex_button_sample(ctx, raw_data);
+}
+
+#ifdef FLEX_BTN_USING_RULE_TABLE
+/**
+ * flex_button_default_rules
+ * 
+ * The built-in gestures: down, click, double click, repeat click,
+ * short press, long press and long hold.
+*/
+static const flex_button_rule_t flex_button_default_rules[] =
+{
+    /* stage: default(button up) */
+    { FLEX_BTN_STAGE_DEFAULT, FLEX_BTN_RULE_PRESSED, FLEX_BTN_RULE_TICK_NONE,
+      FLEX_BTN_PRESS_DOWN, FLEX_BTN_RULE_START, FLEX_BTN_STAGE_DOWN },
+    { FLEX_BTN_STAGE_DEFAULT, FLEX_BTN_RULE_RELEASED, FLEX_BTN_RULE_TICK_NONE,
+      FLEX_BTN_PRESS_NONE, 0, FLEX_BTN_STAGE_DEFAULT },
+
+    /* stage: button down */
+    { FLEX_BTN_STAGE_DOWN, FLEX_BTN_RULE_PRESSED | FLEX_BTN_RULE_CLICKED | FLEX_BTN_RULE_EXCEED, FLEX_BTN_RULE_TICK_CLICK,
+      FLEX_BTN_RULE_EVENT_CLICKS, FLEX_BTN_RULE_RESET_SCAN | FLEX_BTN_RULE_RESET_CLICK, FLEX_BTN_STAGE_DOWN },
+    { FLEX_BTN_STAGE_DOWN, FLEX_BTN_RULE_PRESSED | FLEX_BTN_RULE_NOT_CLICKED | FLEX_BTN_RULE_ONCE, FLEX_BTN_RULE_TICK_HOLD,
+      FLEX_BTN_PRESS_LONG_HOLD, 0, FLEX_BTN_STAGE_DOWN },
+    { FLEX_BTN_STAGE_DOWN, FLEX_BTN_RULE_PRESSED | FLEX_BTN_RULE_NOT_CLICKED | FLEX_BTN_RULE_ONCE, FLEX_BTN_RULE_TICK_LONG,
+      FLEX_BTN_PRESS_LONG_START, 0, FLEX_BTN_STAGE_DOWN },
+    { FLEX_BTN_STAGE_DOWN, FLEX_BTN_RULE_PRESSED | FLEX_BTN_RULE_NOT_CLICKED | FLEX_BTN_RULE_ONCE, FLEX_BTN_RULE_TICK_SHORT,
+      FLEX_BTN_PRESS_SHORT_START, 0, FLEX_BTN_STAGE_DOWN },
+    { FLEX_BTN_STAGE_DOWN, FLEX_BTN_RULE_RELEASED, FLEX_BTN_RULE_TICK_HOLD,
+      FLEX_BTN_PRESS_LONG_HOLD_UP, 0, FLEX_BTN_STAGE_DEFAULT },
+    { FLEX_BTN_STAGE_DOWN, FLEX_BTN_RULE_RELEASED, FLEX_BTN_RULE_TICK_LONG,
+      FLEX_BTN_PRESS_LONG_UP, 0, FLEX_BTN_STAGE_DEFAULT },
+    { FLEX_BTN_STAGE_DOWN, FLEX_BTN_RULE_RELEASED, FLEX_BTN_RULE_TICK_SHORT,
+      FLEX_BTN_PRESS_SHORT_UP, 0, FLEX_BTN_STAGE_DEFAULT },
+    { FLEX_BTN_STAGE_DOWN, FLEX_BTN_RULE_RELEASED, FLEX_BTN_RULE_TICK_NONE,
+      FLEX_BTN_RULE_EVENT_KEEP, FLEX_BTN_RULE_INC_CLICK, FLEX_BTN_STAGE_MULTIPLE_CLICK },
+
+    /* stage: multiple click */
+    { FLEX_BTN_STAGE_MULTIPLE_CLICK, FLEX_BTN_RULE_PRESSED, FLEX_BTN_RULE_TICK_NONE,
+      FLEX_BTN_RULE_EVENT_KEEP, FLEX_BTN_RULE_RESET_SCAN, FLEX_BTN_STAGE_DOWN },
+    { FLEX_BTN_STAGE_MULTIPLE_CLICK, FLEX_BTN_RULE_RELEASED | FLEX_BTN_RULE_EXCEED, FLEX_BTN_RULE_TICK_CLICK,
+      FLEX_BTN_RULE_EVENT_CLICKS, 0, FLEX_BTN_STAGE_DEFAULT },
+};
+
+/**
+ * @brief The time parameter of the button that a rule 'tick' names.
+ * 
+ * @param target: button
+ * @param tick: FLEX_BTN_RULE_TICK_*
+ * @return scan cnts, 0 for FLEX_BTN_RULE_TICK_NONE
+*/
+static uint32_t flex_button_rule_tick(flex_button_t *target, uint8_t tick)
+{
+    switch (tick)
+    {
+    case FLEX_BTN_RULE_TICK_SHORT:
+        return target->short_press_start_tick;
+    case FLEX_BTN_RULE_TICK_LONG:
+        return target->long_press_start_tick;
+    case FLEX_BTN_RULE_TICK_HOLD:
+        return target->long_hold_start_tick;
+    case FLEX_BTN_RULE_TICK_CLICK:
+        return target->max_multiple_clicks_interval;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Find the rule that applies to the button at the specified scan count.
+ * 
+ * @param ctx: button context
+ * @param target: button
+ * @param i: button index
+ * @param scan_cnt: scan count
+ * @return The first rule of the button stage whose conditions are met, NULL when none
+*/
+static const flex_button_rule_t *flex_button_rule_match(flex_button_ctx_t *ctx,
+    flex_button_t *target, btn_index_t i, uint32_t scan_cnt)
+{
+    uint8_t stage = BTN_STATUS(ctx, target, i);
+    const flex_button_rule_t *rule = &ctx->rules[ctx->rule_first[stage]];
+    const flex_button_rule_t *end = &ctx->rules[ctx->rule_first[stage + 1]];
+    uint32_t tick;
+
+    /* The level and click conditions that are not met */
+    uint8_t unmet = (BTN_IS_PRESSED(ctx, i) ? FLEX_BTN_RULE_RELEASED : FLEX_BTN_RULE_PRESSED) |
+        (BTN_CLICK_CNT(ctx, target, i) ? FLEX_BTN_RULE_NOT_CLICKED : FLEX_BTN_RULE_CLICKED);
+
+    for (; rule < end; rule ++)
+    {
+        if (rule->cond & unmet)
+        {
+            continue;
+        }
+
+        if (rule->tick != FLEX_BTN_RULE_TICK_NONE)
+        {
+            tick = flex_button_rule_tick(target, rule->tick);
+            if (rule->cond & FLEX_BTN_RULE_EXCEED)
+            {
+                tick ++;
+            }
+            if (scan_cnt < tick)
+            {
+                continue;
+            }
+        }
+
+        return rule;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief The event that a rule sets.
+ * 
+ * @return button event, FLEX_BTN_RULE_EVENT_KEEP when unchanged
+*/
+static uint8_t flex_button_rule_event(flex_button_ctx_t *ctx,
+    flex_button_t *target, btn_index_t i, const flex_button_rule_t *rule)
+{
+    uint8_t evt = rule->event;
+
+    (void)ctx;
+    (void)target;
+    (void)i;
+
+    if (evt == FLEX_BTN_RULE_EVENT_CLICKS)
+    {
+        evt = BTN_CLICK_CNT(ctx, target, i) < FLEX_BTN_PRESS_REPEAT_CLICK ?
+            BTN_CLICK_CNT(ctx, target, i) : FLEX_BTN_PRESS_REPEAT_CLICK;
+    }
+
+    if ((evt == FLEX_BTN_PRESS_NONE) || (rule->cond & FLEX_BTN_RULE_ONCE))
+    {
+        if (evt == BTN_EVENT(ctx, target, i))
+        {
+            evt = FLEX_BTN_RULE_EVENT_KEEP;
+        }
+    }
+
+    return evt;
+}
+
+/**
+ * @brief Apply the rule of the button in this scan.
+ * 
+ * @param ctx: button context
+ * @param target: button
+ * @param i: button index
+ * @return none
+*/
+static void flex_button_rule_exec(flex_button_ctx_t *ctx, flex_button_t *target, btn_index_t i)
+{
+    const flex_button_rule_t *rule = flex_button_rule_match(ctx, target, i, BTN_SCAN_CNT(ctx, target, i));
+    uint8_t evt;
+
+    if (!rule)
+    {
+        return;
+    }
+
+    if (rule->action & FLEX_BTN_RULE_START)
+    {
+        BTN_SCAN_CNT(ctx, target, i) = 0;
+        BTN_CLICK_CNT(ctx, target, i) = 0;
+    }
+
+    evt = flex_button_rule_event(ctx, target, i, rule);
+    if (evt == FLEX_BTN_PRESS_NONE)
+    {
+        BTN_EVENT(ctx, target, i) = FLEX_BTN_PRESS_NONE;
+    }
+    else if (evt != FLEX_BTN_RULE_EVENT_KEEP)
+    {
+        EVENT_SET_AND_EXEC_CB(ctx, target, i, evt);
+    }
+
+    if (rule->action & FLEX_BTN_RULE_RESET_SCAN)
+    {
+        BTN_SCAN_CNT(ctx, target, i) = 0;
+    }
+    if (rule->action & FLEX_BTN_RULE_RESET_CLICK)
+    {
+        BTN_CLICK_CNT(ctx, target, i) = 0;
+    }
+    if (rule->action & FLEX_BTN_RULE_INC_CLICK)
+    {
+        BTN_CLICK_CNT(ctx, target, i) ++;
+    }
+
+    BTN_STATUS(ctx, target, i) = rule->next;
+}
+
+/**
+ * flex_button_ctx_rules_set
+ * 
+ * @brief Set the gesture rules of the context, before registering the buttons.
+ * 
+ * @param ctx: button context
+ * @param rules: rule table grouped by stage in ascending order, NULL for the built-in gestures
+ * @param num: number of rules, up to 255
+ * @return 0 on success, -1 when the table is invalid
+*/
+int32_t flex_button_ctx_rules_set(flex_button_ctx_t *ctx, const flex_button_rule_t *rules, uint8_t num)
+{
+    uint8_t stage;
+    uint8_t k;
+
+    if (!rules)
+    {
+        rules = flex_button_default_rules;
+        num = sizeof(flex_button_default_rules) / sizeof(flex_button_default_rules[0]);
+    }
+
+    for (k = 0; k < num; k ++)
+    {
+        if ((rules[k].stage >= FLEX_BTN_RULE_STAGE_NUM) || (rules[k].next >= FLEX_BTN_RULE_STAGE_NUM) ||
+            ((k > 0) && (rules[k].stage < rules[k - 1].stage)))
+        {
+            return -1;
+        }
+    }
+
+    /* rule_first[stage] is the first rule of the stage or a later stage */
+    for (stage = 0, k = 0; stage <= FLEX_BTN_RULE_STAGE_NUM; stage ++)
+    {
+        while ((k < num) && (rules[k].stage < stage))
+        {
+            k ++;
+        }
+        ctx->rule_first[stage] = k;
+    }
+    ctx->rules = rules;
+
+    return 0;
+}
+#endif
+
+#ifdef FLEX_BTN_USING_COMBO
+/**
+ * @brief Compare a combination step with the pressing state of this scan.
+ * 
+ * @param ctx: button context
+ * @param step: buttons of the step, FLEX_BTN_STATUS_WORDS words
+ * @param edge: buttons pressed in this scan
+ * @return 1 when all buttons of the step are pressed,
+ *         -1 when a button out of the step is pressed in this scan, 0 otherwise
+*/
+static int8_t flex_button_combo_test(flex_button_ctx_t *ctx, const btn_type_t *step, const btn_type_t *edge)
+{
+    int8_t full = 1;
+    uint8_t w;
+
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        if (edge[w] & ~step[w])
+        {
+            return -1;
+        }
+        if ((ctx->status_reg[w] & step[w]) != step[w])
+        {
+            full = 0;
+        }
+    }
+
+    return full;
+}
+
+/**
+ * @brief Report a combination, by its callback or in the event queue.
+ * 
+ * @param ctx: button context
+ * @param combo: combination structure instance
+ * @return none
+*/
+static void flex_button_combo_report(flex_button_ctx_t *ctx, flex_button_combo_t *combo)
+{
+    const btn_type_t *step = &combo->steps[(combo->step_num - 1) * FLEX_BTN_STATUS_WORDS];
+    uint8_t w;
+
+    combo->step = combo->step_num + 1;
+
+    /* The buttons of the last step report nothing more until they are idle */
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        ctx->combo_suppress[w] |= step[w];
+    }
+
+#ifdef FLEX_BTN_USING_STATS
+    {
+        uint32_t latency = 0xFFFFFFFF;
+        btn_type_t bits;
+        btn_index_t i;
+
+        /* From the last level change of the buttons of the last step */
+        for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+        {
+            for (bits = step[w]; bits; bits &= ~((btn_type_t)1 << i))
+            {
+                i = FLEX_BTN_MSB(bits);
+                if (ctx->stats_clock - ctx->stats_edge[i + w * FLEX_BTN_WORD_BITS] < latency)
+                {
+                    latency = ctx->stats_clock - ctx->stats_edge[i + w * FLEX_BTN_WORD_BITS];
+                }
+            }
+        }
+        flex_button_stats_event(ctx, FLEX_BTN_PRESS_COMBO, latency);
+    }
+#endif
+#ifdef FLEX_BTN_EVENT_PUSH
+    flex_button_event_push(ctx, combo->id, FLEX_BTN_PRESS_COMBO, 0, 0);
+#else
+    if (combo->cb)
+    {
+        BTN_STATS_CB_BEGIN(ctx);
+        combo->cb(combo);
+        BTN_STATS_CB_END(ctx);
+    }
+#endif
+}
+
+/**
+ * @brief Report the events held for the buttons leaving the last step of a
+ *        combination not reported, in the order of flex_button_event_t,
+ *        and drop them for the buttons of a reported combination.
+ * 
+ * @param ctx: button context
+ * @param release: buttons leaving the hold, FLEX_BTN_STATUS_WORDS words
+ * @return none
+*/
+static void flex_button_combo_release(flex_button_ctx_t *ctx, const btn_type_t *release)
+{
+    flex_button_t* target;
+    btn_index_t i;
+    btn_index_t at;
+    btn_type_t bits;
+    uint16_t held;
+    uint8_t event;
+    uint8_t evt;
+    int16_t w;
+
+    BTN_WALK_START(ctx, target, at);
+    for (w = FLEX_BTN_STATUS_WORDS - 1; w >= 0; w --)
+    {
+        for (bits = release[w]; bits; )
+        {
+            i = FLEX_BTN_MSB(bits);
+            bits &= ~((btn_type_t)1 << i);
+            i += w * FLEX_BTN_WORD_BITS;
+
+            held = ctx->combo_held[i];
+            ctx->combo_held[i] = 0;
+            if (!held || BTN_SUPPRESSED(ctx, i))
+            {
+                continue;
+            }
+            BTN_WALK_TO(ctx, target, at, i);
+
+            /* Report them as at the time they were held, then restore the current event */
+            event = BTN_EVENT(ctx, target, i);
+            for (evt = 0; held; evt ++, held >>= 1)
+            {
+                if (held & 1)
+                {
+                    EVENT_SET_AND_EXEC_CB(ctx, target, i, evt);
+                }
+            }
+            BTN_EVENT(ctx, target, i) = event;
+        }
+    }
+}
+
+/**
+ * @brief Match all combinations with the pressing state of this scan.
+ *        Runs before the button events, so the events of the buttons of a
+ *        last step are already suppressed in the scan that reports it.
+ *        While a last step is held for 'hold_tick', the events of its
+ *        buttons are held, and reported when the combination is given up.
+ * 
+ * @param ctx: button context
+ * @param elapsed: scan cycles since the last call
+ * @return none
+*/
+static void flex_button_combo_scan(flex_button_ctx_t *ctx, uint16_t elapsed)
+{
+    btn_type_t edge[FLEX_BTN_STATUS_WORDS];
+    btn_type_t hold[FLEX_BTN_STATUS_WORDS];
+    btn_type_t release[FLEX_BTN_STATUS_WORDS];
+    btn_type_t any_edge = 0;
+    btn_type_t any_release = 0;
+    flex_button_combo_t *combo;
+    const btn_type_t *step;
+    int8_t result;
+    uint8_t w;
+
+    /* Buttons pressed in this scan */
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        edge[w] = ctx->status_reg[w] & ~ctx->combo_prev[w];
+        ctx->combo_prev[w] = ctx->status_reg[w];
+        any_edge |= edge[w];
+    }
+
+    for (combo = ctx->combo_head; combo != NULL; combo = combo->next)
+    {
+        if (combo->step > 0)
+        {
+            uint32_t cnt = (uint32_t)combo->cnt + elapsed;
+
+            combo->cnt = cnt > 0xFFFF ? 0xFFFF : (uint16_t)cnt;
+        }
+
+        if (combo->step >= combo->step_num)
+        {
+            /* Last step held, until a button is released or another one is pressed */
+            step = &combo->steps[(combo->step_num - 1) * FLEX_BTN_STATUS_WORDS];
+            if (flex_button_combo_test(ctx, step, edge) == 1)
+            {
+                if ((combo->step == combo->step_num) && (combo->cnt >= combo->hold_tick))
+                {
+                    flex_button_combo_report(ctx, combo);
+                }
+                continue;
+            }
+            combo->step = 0;
+        }
+        else if ((combo->step > 0) && (combo->cnt > combo->interval_tick))
+        {
+            combo->step = 0; /* next step too late */
+        }
+
+        if (!any_edge)
+        {
+            continue;
+        }
+
+        step = &combo->steps[combo->step * FLEX_BTN_STATUS_WORDS];
+        result = flex_button_combo_test(ctx, step, edge);
+        if ((result < 0) && (combo->step > 0))
+        {
+            /* Wrong button, it may start the combination again */
+            combo->step = 0;
+            step = combo->steps;
+            result = flex_button_combo_test(ctx, step, edge);
+        }
+
+        if (result == 1)
+        {
+            combo->step ++;
+            combo->cnt = 0;
+
+            if ((combo->step == combo->step_num) && (combo->hold_tick == 0))
+            {
+                flex_button_combo_report(ctx, combo);
+            }
+        }
+    }
+
+    /* Hold the events of the buttons of the last steps waiting for 'hold_tick' */
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        hold[w] = 0;
+    }
+    for (combo = ctx->combo_head; combo != NULL; combo = combo->next)
+    {
+        if (combo->step == combo->step_num)
+        {
+            step = &combo->steps[(combo->step_num - 1) * FLEX_BTN_STATUS_WORDS];
+            for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+            {
+                hold[w] |= step[w];
+            }
+        }
+    }
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        hold[w] &= ~ctx->combo_suppress[w];
+        release[w] = ctx->combo_hold[w] & ~hold[w];
+        ctx->combo_hold[w] = hold[w];
+        any_release |= release[w];
+    }
+    if (any_release)
+    {
+        flex_button_combo_release(ctx, release);
+    }
+}
+#endif
+
+#ifdef FLEX_BTN_USING_REPEAT
+/**
+ * @brief The interval from the current repeat to the next one.
+ * 
+ * @param target: button structure instance
+ * @return Scan cnts, at least 1
+*/
+static uint16_t flex_button_repeat_interval(flex_button_t *target)
+{
+    uint16_t interval = target->repeat_rate_tick;
+
+    if (target->repeat_accel_tick && (interval > target->repeat_min_tick))
+    {
+        uint32_t dec = (uint32_t)(target->repeat_cnt - 1) * target->repeat_accel_tick;
+
+        if (dec > (uint32_t)(interval - target->repeat_min_tick))
+        {
+            dec = interval - target->repeat_min_tick;
+        }
+        interval -= (uint16_t)dec;
+    }
+
+    return interval > 0 ? interval : 1;
+}
+
+/**
+ * @brief Auto-repeat of a held button, replaces the gestures while
+ *        BTN_REPEATING is true.
+ *        Its own countdown, so the repeat goes on when 'scan_cnt' saturates.
+ * 
+ * @param ctx: button context
+ * @param target: button structure instance
+ * @param i: button index
+ * @param elapsed: scan cycles since the last call
+ * @return none
+*/
+static void flex_button_repeat(flex_button_ctx_t *ctx, flex_button_t *target, btn_index_t i, uint16_t elapsed)
+{
+    uint16_t scan_cnt = BTN_SCAN_CNT(ctx, target, i);
+    uint16_t interval;
+    uint16_t over;
+
+    if (!BTN_IS_PRESSED(ctx, i)) /* released after a repeat or the gestures, no click */
+    {
+        /* One up event, the start events were replaced by the repeats */
+        BTN_STATUS(ctx, target, i) = FLEX_BTN_STAGE_DEFAULT;
+        EVENT_SET_AND_EXEC_CB(ctx, target, i, FLEX_BTN_PRESS_REPEAT_UP);
+        target->repeat_cnt = 0;
+        return;
+    }
+
+    if (target->repeat_cnt == 0)
+    {
+        if (scan_cnt < target->repeat_delay_tick)
+        {
+            return;
+        }
+        over = scan_cnt - target->repeat_delay_tick;
+    }
+    else
+    {
+        if (elapsed < target->repeat_wait)
+        {
+            target->repeat_wait -= elapsed;
+            return;
+        }
+        over = elapsed - target->repeat_wait;
+    }
+
+    if (target->repeat_cnt < 0xFFFF)
+    {
+        target->repeat_cnt ++;
+    }
+
+    /* A late scan shortens the next interval, the missed repeats are dropped */
+    interval = flex_button_repeat_interval(target);
+    target->repeat_wait = (over < interval) ? interval - over : interval;
+
+    EVENT_SET_AND_EXEC_CB(ctx, target, i, FLEX_BTN_PRESS_REPEAT);
+}
+#endif
+
+#ifdef FLEX_BTN_USING_ENCODER
+/**
+ * Phase changes of a quadrature encoder, indexed by the last phases << 2 | the new phases.
+ * +1 clockwise, -1 counterclockwise, 0 unchanged or a missed phase (both changed).
+*/
+static const int8_t flex_button_encoder_table[16] =
+{
+     0, +1, -1,  0,
+    -1,  0,  0, +1,
+    +1,  0,  0, -1,
+     0, -1, +1,  0
+};
+
+/**
+ * @brief Read all encoders and report the detents turned in this scan.
+ * 
+ * @param ctx: button context
+ * @param elapsed: scan cycles since the last call
+ * @return none
+*/
+static void flex_button_encoder_scan(flex_button_ctx_t *ctx, uint16_t elapsed)
+{
+    flex_button_encoder_t *encoder;
+    uint8_t phase;
+    int8_t spd;
+    int16_t step;
+    uint32_t cnt;
+
+    for (encoder = ctx->encoder_head; encoder != NULL; encoder = encoder->next)
+    {
+        phase = encoder->usr_encoder_read(encoder) & 3;
+        encoder->sub_step += flex_button_encoder_table[(encoder->phase << 2) | phase];
+        encoder->phase = phase;
+
+        cnt = (uint32_t)encoder->cnt + elapsed;
+        encoder->cnt = cnt > FLEX_MS_TO_SCAN_CNT(1000) ? FLEX_MS_TO_SCAN_CNT(1000) : (uint16_t)cnt;
+
+        spd = (int8_t)encoder->steps_per_detent;
+        if ((encoder->sub_step < spd) && (encoder->sub_step > -spd))
+        {
+            continue;
+        }
+
+        step = encoder->sub_step / spd;
+        encoder->sub_step -= (int8_t)(step * spd);
+        encoder->position += step;
+        encoder->step = step;
+
+        /* Detents per second, over the time since the last detent */
+        encoder->velocity = (int16_t)((int32_t)step * FLEX_MS_TO_SCAN_CNT(1000) /
+            (encoder->cnt > 0 ? encoder->cnt : 1));
+        encoder->cnt = 0;
+
+#ifdef FLEX_BTN_USING_STATS
+        flex_button_stats_event(ctx, FLEX_BTN_PRESS_STEP, 0);
+#endif
+#ifdef FLEX_BTN_EVENT_PUSH
+        flex_button_event_push(ctx, encoder->id, FLEX_BTN_PRESS_STEP,
+            (uint16_t)encoder->step, encoder->velocity);
+#else
+        if (encoder->cb)
+        {
+            BTN_STATS_CB_BEGIN(ctx);
+            encoder->cb(encoder);
+            BTN_STATS_CB_END(ctx);
+        }
+#endif
+    }
+}
+#endif
+
+/**
+ * @brief Handle all key events in one scan cycle.
+ *        Must be used after 'flex_button_read' API
+ * 
+ * @param ctx: button context
+ * @param elapsed: scan cycles since the last call, 1 when scanning periodically
+ * @return Activated button count
+*/
+static uint8_t flex_button_process(flex_button_ctx_t *ctx, uint16_t elapsed)
+{
+    btn_index_t i;
+    btn_index_t at;
+    int16_t w;
+    btn_index_t active_btn_cnt = 0;
+    flex_button_t* target;
+    btn_type_t pending;
+
+#ifdef FLEX_BTN_USING_STATS
+    flex_button_stats_process(ctx, elapsed);
+#endif
+#ifdef FLEX_BTN_USING_COMBO
+    flex_button_combo_scan(ctx, elapsed);
+#endif
+
+    BTN_WALK_START(ctx, target, at);
+    for (w = FLEX_BTN_STATUS_WORDS - 1; w >= 0; w --)
+    {
+        pending = ctx->status_reg[w] | ctx->active_reg[w];
+
+        if (pending == 0)
+        {
+            continue; /* all buttons of this word idle, nothing changed */
+        }
+
+        ctx->active_reg[w] = 0;
+
+        /* Visit the pressed or active buttons only, last registered first */
+        while (pending)
+        {
+            i = FLEX_BTN_MSB(pending);
+            pending &= ~((btn_type_t)1 << i);
+            i += w * FLEX_BTN_WORD_BITS;
+            BTN_WALK_TO(ctx, target, at, i);
+
+            if (BTN_STATUS(ctx, target, i) > FLEX_BTN_STAGE_DEFAULT)
+            {
+                uint32_t scan_cnt = (uint32_t)BTN_SCAN_CNT(ctx, target, i) + elapsed;
+
+                if (scan_cnt >= ((1UL << (sizeof(BTN_SCAN_CNT(ctx, target, i)) * 8)) - 1))
+                {
+                    scan_cnt = target->long_hold_start_tick;
+                }
+                BTN_SCAN_CNT(ctx, target, i) = (uint16_t)scan_cnt;
+            }
+
+#ifdef FLEX_BTN_USING_REPEAT
+            if (BTN_REPEATING(ctx, target, i))
+            {
+                flex_button_repeat(ctx, target, i, elapsed);
+            }
+            else
+#endif
+#ifdef FLEX_BTN_USING_RULE_TABLE
+            flex_button_rule_exec(ctx, target, i);
+#else
+            switch (BTN_STATUS(ctx, target, i))
+            {
+            case FLEX_BTN_STAGE_DEFAULT: /* stage: default(button up) */
+                if (BTN_IS_PRESSED(ctx, i)) /* is pressed */
+                {
+                    BTN_SCAN_CNT(ctx, target, i) = 0;
+                    BTN_CLICK_CNT(ctx, target, i) = 0;
+
+                    EVENT_SET_AND_EXEC_CB(ctx, target, i, FLEX_BTN_PRESS_DOWN);
+
+                    /* swtich to button down stage */
+                    BTN_STATUS(ctx, target, i) = FLEX_BTN_STAGE_DOWN;
+                }
+                else
+                {
+                    BTN_EVENT(ctx, target, i) = FLEX_BTN_PRESS_NONE;
+                }
+                break;
+
+            case FLEX_BTN_STAGE_DOWN: /* stage: button down */
+                if (BTN_IS_PRESSED(ctx, i)) /* is pressed */
+                {
+                    if (BTN_CLICK_CNT(ctx, target, i) > 0) /* multiple click */
+                    {
+                        if (BTN_SCAN_CNT(ctx, target, i) > target->max_multiple_clicks_interval)
+                        {
+                            EVENT_SET_AND_EXEC_CB(ctx, target, i, 
+                                BTN_CLICK_CNT(ctx, target, i) < FLEX_BTN_PRESS_REPEAT_CLICK ? 
+                                    BTN_CLICK_CNT(ctx, target, i) :
+                                    FLEX_BTN_PRESS_REPEAT_CLICK);
+
+                            /* swtich to button down stage */
+                            BTN_STATUS(ctx, target, i) = FLEX_BTN_STAGE_DOWN;
+                            BTN_SCAN_CNT(ctx, target, i) = 0;
+                            BTN_CLICK_CNT(ctx, target, i) = 0;
+                        }
+                    }
+                    else if (BTN_SCAN_CNT(ctx, target, i) >= target->long_hold_start_tick)
+                    {
+                        if (BTN_EVENT(ctx, target, i) != FLEX_BTN_PRESS_LONG_HOLD)
+                        {
+                            EVENT_SET_AND_EXEC_CB(ctx, target, i, FLEX_BTN_PRESS_LONG_HOLD);
+                        }
+                    }
+                    else if (BTN_SCAN_CNT(ctx, target, i) >= target->long_press_start_tick)
+                    {
+                        if (BTN_EVENT(ctx, target, i) != FLEX_BTN_PRESS_LONG_START)
+                        {
+                            EVENT_SET_AND_EXEC_CB(ctx, target, i, FLEX_BTN_PRESS_LONG_START);
+                        }
+                    }
+                    else if (BTN_SCAN_CNT(ctx, target, i) >= target->short_press_start_tick)
+                    {
+                        if (BTN_EVENT(ctx, target, i) != FLEX_BTN_PRESS_SHORT_START)
+                        {
+                            EVENT_SET_AND_EXEC_CB(ctx, target, i, FLEX_BTN_PRESS_SHORT_START);
+                        }
+                    }
+                }
+                else /* button up */
+                {
+                    if (BTN_SCAN_CNT(ctx, target, i) >= target->long_hold_start_tick)
+                    {
+                        EVENT_SET_AND_EXEC_CB(ctx, target, i, FLEX_BTN_PRESS_LONG_HOLD_UP);
+                        BTN_STATUS(ctx, target, i) = FLEX_BTN_STAGE_DEFAULT;
+                    }
+                    else if (BTN_SCAN_CNT(ctx, target, i) >= target->long_press_start_tick)
+                    {
+                        EVENT_SET_AND_EXEC_CB(ctx, target, i, FLEX_BTN_PRESS_LONG_UP);
+                        BTN_STATUS(ctx, target, i) = FLEX_BTN_STAGE_DEFAULT;
+                    }
+                    else if (BTN_SCAN_CNT(ctx, target, i) >= target->short_press_start_tick)
+                    {
+                        EVENT_SET_AND_EXEC_CB(ctx, target, i, FLEX_BTN_PRESS_SHORT_UP);
+                        BTN_STATUS(ctx, target, i) = FLEX_BTN_STAGE_DEFAULT;
+                    }
+                    else
+                    {
+                        /* swtich to multiple click stage */
+                        BTN_STATUS(ctx, target, i) = FLEX_BTN_STAGE_MULTIPLE_CLICK;
+                        BTN_CLICK_CNT(ctx, target, i) ++;
+                    }
+                }
+                break;
+
+            case FLEX_BTN_STAGE_MULTIPLE_CLICK: /* stage: multiple click */
+                if (BTN_IS_PRESSED(ctx, i)) /* is pressed */
+                {
+                    /* swtich to button down stage */
+                    BTN_STATUS(ctx, target, i) = FLEX_BTN_STAGE_DOWN;
+                    BTN_SCAN_CNT(ctx, target, i) = 0;
+                }
+                else
+                {
+                    if (BTN_SCAN_CNT(ctx, target, i) > target->max_multiple_clicks_interval)
+                    {
+                        EVENT_SET_AND_EXEC_CB(ctx, target, i, 
+                            BTN_CLICK_CNT(ctx, target, i) < FLEX_BTN_PRESS_REPEAT_CLICK ? 
+                                BTN_CLICK_CNT(ctx, target, i) :
+                                FLEX_BTN_PRESS_REPEAT_CLICK);
+
+                        /* swtich to default stage */
+                        BTN_STATUS(ctx, target, i) = FLEX_BTN_STAGE_DEFAULT;
+                    }
+                }
+                break;
+            }
+#endif
+            
+            if (BTN_STATUS(ctx, target, i) > FLEX_BTN_STAGE_DEFAULT)
+            {
+                active_btn_cnt ++;
+                ctx->active_reg[w] |= BTN_BIT(i);
+            }
+            else if (BTN_EVENT(ctx, target, i) != FLEX_BTN_PRESS_NONE)
+            {
+                ctx->active_reg[w] |= BTN_BIT(i);
+            }
+            BTN_SNAPSHOT_SAVE(ctx, target, i);
+        }
+    }
+
+#ifdef FLEX_BTN_USING_COMBO
+    /* Report the events of the combination buttons again once they are idle */
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        ctx->combo_suppress[w] &= ctx->status_reg[w] | ctx->active_reg[w];
+    }
+#endif
+
+#if FLEX_BTN_STATUS_WORDS < 8
+    return active_btn_cnt;
+#else
+    return active_btn_cnt > 0xFF ? 0xFF : (uint8_t)active_btn_cnt;
+#endif
+}
+
+/**
+ * flex_button_ctx_event_read
+ * 
+ * @brief Get the button event of the specified button.
+ *        From threads other than the scan thread, use flex_button_ctx_snapshot.
+ * 
+ * @param ctx: button context
+ * @param button: button structure instance
+ * @return button event, FLEX_BTN_PRESS_NONE when the button is not registered
+ *         with FLEX_BTN_USING_ARRAY_STORAGE
+*/
+flex_button_event_t flex_button_ctx_event_read(flex_button_ctx_t *ctx, flex_button_t* button)
+{
+#ifdef FLEX_BTN_USING_ARRAY_STORAGE
+    int32_t i = flex_button_index(ctx, button);
+
+    if (i < 0)
+    {
+        return FLEX_BTN_PRESS_NONE;
+    }
+
+    return (flex_button_event_t)(ctx->btn_event[i]);
+#else
+    (void)ctx;
+
+    return (flex_button_event_t)(button->event);
+#endif
+}
+
+/**
+ * flex_button_ctx_scan
+ * 
+ * @brief Start key scan.
+ *        Need to be called cyclically within the specified period.
+ *        Sample cycle: 5 - 20ms
+ *        With FLEX_BTN_USING_TIMESTAMP, the period may vary at runtime,
+ *        button timing follows 'now' instead of the scan count.
+ * 
+ * @param ctx: button context
+ * @param now: only with FLEX_BTN_USING_TIMESTAMP, monotonic time in milliseconds
+ * @return Activated button count
+*/
+#ifdef FLEX_BTN_USING_TIMESTAMP
+uint8_t flex_button_ctx_scan(flex_button_ctx_t *ctx, uint32_t now)
+{
+    uint32_t elapsed = now - ctx->last_ts;
+    uint8_t active;
+#ifdef FLEX_BTN_USING_EVENT_BATCH
+    flex_button_batch_event_t batch[FLEX_BTN_EVENT_BATCH_SIZE];
+#endif
+
+    BTN_STATS_SCAN_BEGIN(ctx);
+    BTN_BATCH_BEGIN(ctx, batch);
+    BTN_SNAPSHOT_BEGIN(ctx);
+    ctx->last_ts = now;
+
+    flex_button_read(ctx);
+#ifdef FLEX_BTN_USING_ENCODER
+    flex_button_encoder_scan(ctx, elapsed > 0xFFFF ? 0xFFFF : (uint16_t)elapsed);
+#endif
+    active = flex_button_process(ctx, elapsed > 0xFFFF ? 0xFFFF : (uint16_t)elapsed);
+    BTN_SNAPSHOT_END(ctx);
+
+    return BTN_STATS_SCAN_END(ctx, BTN_BATCH_END(ctx, active));
+}
+#else
+uint8_t flex_button_ctx_scan(flex_button_ctx_t *ctx)
+{
+    uint8_t active;
+#ifdef FLEX_BTN_USING_EVENT_BATCH
+    flex_button_batch_event_t batch[FLEX_BTN_EVENT_BATCH_SIZE];
+#endif
+
+    BTN_STATS_SCAN_BEGIN(ctx);
+    BTN_BATCH_BEGIN(ctx, batch);
+    BTN_SNAPSHOT_BEGIN(ctx);
+#ifdef FLEX_BTN_USING_EVENT_QUEUE
+    ctx->scan_total ++;
+#endif
+    flex_button_read(ctx);
+#ifdef FLEX_BTN_USING_ENCODER
+    flex_button_encoder_scan(ctx, 1);
+#endif
+    active = flex_button_process(ctx, 1);
+    BTN_SNAPSHOT_END(ctx);
+
+    return BTN_STATS_SCAN_END(ctx, BTN_BATCH_END(ctx, active));
+}
+#endif
+
+#ifdef FLEX_BTN_USING_EVENT_BATCH
+/**
+ * flex_button_ctx_batch_handler
+ * 
+ * @brief Set the function that receives the events of each scan together,
+ *        instead of calling the 'cb' of the buttons one by one.
+ *        It is called once at the end of the scan, and not at all when the
+ *        scan has no event. A scan with more than FLEX_BTN_EVENT_BATCH_SIZE
+ *        events calls it once for each full array, in event order.
+ * 
+ * @param ctx: button context
+ * @param handler: the handler, NULL to drop the events
+ * @param arg: the first argument of the handler
+ * @return none
+*/
+void flex_button_ctx_batch_handler(flex_button_ctx_t *ctx, flex_button_batch_handler_t handler, void *arg)
+{
+    ctx->batch_handler = handler;
+    ctx->batch_arg = arg;
+}
+#endif
+
+#ifdef FLEX_BTN_USING_TRACE
+/**
+ * flex_button_ctx_trace_hook
+ * 
+ * @brief Set the function that receives the pressing state of each scan,
+ *        e.g. flex_button_trace_record to record the scans for replay.
+ * 
+ * @param ctx: button context
+ * @param hook: the hook, NULL to stop
+ * @param arg: the first argument of the hook
+ * @return none
+*/
+void flex_button_ctx_trace_hook(flex_button_ctx_t *ctx, flex_button_trace_hook_t hook, void *arg)
+{
+    ctx->trace_hook = hook;
+    ctx->trace_arg = arg;
+}
+
+/**
+ * flex_button_ctx_replay
+ * 
+ * @brief Scan with a recorded pressing state instead of reading the buttons.
+ *        Replaying the recorded scans in order reports the same events.
+ * 
+ * @param ctx: button context
+ * @param pressed: pressing state of the buttons, bit i is the button at index i,
+ *        FLEX_BTN_STATUS_WORDS words
+ * @param now: only with FLEX_BTN_USING_TIMESTAMP, monotonic time in milliseconds
+ * @return Activated button count
+*/
+#ifdef FLEX_BTN_USING_TIMESTAMP
+uint8_t flex_button_ctx_replay(flex_button_ctx_t *ctx, const btn_type_t *pressed, uint32_t now)
+#else
+uint8_t flex_button_ctx_replay(flex_button_ctx_t *ctx, const btn_type_t *pressed)
+#endif
+{
+    btn_type_t raw_data[FLEX_BTN_STATUS_WORDS];
+    uint8_t active;
+    uint8_t w;
+#ifdef FLEX_BTN_USING_EVENT_BATCH
+    flex_button_batch_event_t batch[FLEX_BTN_EVENT_BATCH_SIZE];
+#endif
+#ifdef FLEX_BTN_USING_TIMESTAMP
+    uint32_t elapsed = now - ctx->last_ts;
+
+    BTN_STATS_SCAN_BEGIN(ctx);
+    ctx->last_ts = now;
+#else
+    uint32_t elapsed = 1;
+
+    BTN_STATS_SCAN_BEGIN(ctx);
+#ifdef FLEX_BTN_USING_EVENT_QUEUE
+    ctx->scan_total ++;
+#endif
+#endif
+    BTN_BATCH_BEGIN(ctx, batch);
+    BTN_SNAPSHOT_BEGIN(ctx);
+
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        raw_data[w] = pressed[w] & BTN_ENABLE(ctx)[w];
+    }
+
+    flex_button_sample(ctx, raw_data);
+    active = flex_button_process(ctx, elapsed > 0xFFFF ? 0xFFFF : (uint16_t)elapsed);
+    BTN_SNAPSHOT_END(ctx);
+
+    return BTN_STATS_SCAN_END(ctx, BTN_BATCH_END(ctx, active));
+}
+#endif
+
+#ifdef FLEX_BTN_USING_EVENT_QUEUE
+/**
+ * flex_button_ctx_event_pop
+ * 
+ * @brief Take the oldest queued button event.
+ *        Only one thread may call it, it never blocks the scan.
+ * 
+ * @param ctx: button context
+ * @param record: the event record
+ * @return 1 when an event is taken, 0 when the queue is empty
+*/
+uint8_t flex_button_ctx_event_pop(flex_button_ctx_t *ctx, flex_button_event_record_t *record)
+{
+    uint16_t tail = ctx->event_queue.tail;
+
+    if (tail == ctx->event_queue.head)
+    {
+        return 0;
+    }
+
+    /* Read the record after seeing it published */
+    FLEX_BTN_MEMORY_BARRIER();
+    *record = ctx->event_queue.record[tail & (FLEX_BTN_EVENT_QUEUE_SIZE - 1)];
+
+    /* The record must be read before the slot is released */
+    FLEX_BTN_MEMORY_BARRIER();
+    ctx->event_queue.tail = tail + 1;
+
+    return 1;
+}
+
+/**
+ * flex_button_ctx_event_overflow
+ * 
+ * @brief Get the number of events dropped because the queue was full.
+ * 
+ * @param ctx: button context
+ * @return Dropped event count
+*/
+uint32_t flex_button_ctx_event_overflow(flex_button_ctx_t *ctx)
+{
+    return ctx->event_queue.overflow;
+}
+#endif
+
+#ifdef FLEX_BTN_USING_STATS
+/**
+ * flex_button_ctx_stats_get
+ * 
+ * @brief Get the statistics of the scans since the start or the last reset.
+ * 
+ * @param ctx: button context
+ * @param stats: the statistics
+ * @return none
+*/
+void flex_button_ctx_stats_get(flex_button_ctx_t *ctx, flex_button_stats_t *stats)
+{
+    *stats = ctx->stats;
+    stats->scan_cycles_avg = ctx->stats.scan_cnt ?
+        (uint32_t)(ctx->scan_cycles_sum / ctx->stats.scan_cnt) : 0;
+}
+
+/**
+ * flex_button_ctx_stats_reset
+ * 
+ * @brief Clear the statistics.
+ * 
+ * @param ctx: button context
+ * @return none
+*/
+void flex_button_ctx_stats_reset(flex_button_ctx_t *ctx)
+{
+    uint8_t *p = (uint8_t *)&ctx->stats;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(flex_button_stats_t); i ++)
+    {
+        p[i] = 0;
+    }
+    ctx->scan_cycles_sum = 0;
+}
+#endif
+
+#ifdef FLEX_BTN_USING_SNAPSHOT
+/**
+ * flex_button_ctx_snapshot
+ * 
+ * @brief Copy the scan state of all buttons, consistent as between two scans.
+ *        For other threads, e.g. diagnostics or UI, it never blocks the scan:
+ *        while a scan runs, it waits with FLEX_BTN_SNAPSHOT_WAIT up to
+ *        FLEX_BTN_SNAPSHOT_SPIN times, and the copy is taken again when a scan
+ *        changed the state meanwhile, up to FLEX_BTN_SNAPSHOT_RETRY times.
+ *        Only the context is read, not the registered buttons.
+ *        Fails when called from the button callbacks, they can read the
+ *        state directly.
+ * 
+ * @param ctx: button context
+ * @param snapshot: the copy
+ * @return 1 on success, 0 when the scans kept changing the state, try again later
+*/
+uint8_t flex_button_ctx_snapshot(flex_button_ctx_t *ctx, flex_button_snapshot_t *snapshot)
+{
+    flex_button_snapshot_button_t *copy;
+    uint32_t seq;
+    uint32_t spin = 0;
+    btn_index_t i, num;
+    uint8_t retry = 0;
+    uint8_t w;
+
+    while (retry < FLEX_BTN_SNAPSHOT_RETRY)
+    {
+        seq = ctx->snapshot_seq;
+        if (seq & 1)
+        {
+            /* A scan is running, wait until it ends before copying */
+            if (++ spin >= FLEX_BTN_SNAPSHOT_SPIN)
+            {
+                return 0;
+            }
+            FLEX_BTN_SNAPSHOT_WAIT();
+            continue;
+        }
+
+        /* The state must be read after the sequence */
+        FLEX_BTN_MEMORY_BARRIER();
+
+        for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+        {
+            snapshot->status_reg[w] = ctx->status_reg[w];
+            snapshot->active_reg[w] = ctx->active_reg[w];
+            snapshot->mask[w] = ctx->mask[w];
+            snapshot->enable[w] = BTN_ENABLE(ctx)[w];
+        }
+
+        /* May be torn by a scan, the copy is dropped then, but stays in range */
+        num = BTN_SLOTS(ctx);
+        if (num > FLEX_BTN_MAX_NUM)
+        {
+            num = FLEX_BTN_MAX_NUM;
+        }
+
+        for (i = 0; i < num; i ++)
+        {
+            copy = &snapshot->button[i];
+
+            if (!(snapshot->mask[BTN_WORD(i)] & BTN_BIT(i)))
+            {
+                copy->scan_cnt = 0;
+                copy->click_cnt = 0;
+                copy->id = 0;
+                copy->event = FLEX_BTN_PRESS_NONE;
+                copy->status = FLEX_BTN_STAGE_DEFAULT;
+                continue;
+            }
+
+#ifdef FLEX_BTN_USING_ARRAY_STORAGE
+            /* The button array is fixed, only its 'id' is read */
+            copy->scan_cnt = ctx->btn_scan_cnt[i];
+            copy->click_cnt = ctx->btn_click_cnt[i];
+            copy->id = ctx->btn_array[i].id;
+            copy->event = ctx->btn_event[i];
+            copy->status = ctx->btn_status[i];
+#else
+            *copy = ctx->snapshot_button[i];
+#endif
+        }
+        snapshot->button_num = num;
+
+        /* The state must be read before the sequence is checked again */
+        FLEX_BTN_MEMORY_BARRIER();
+        if (ctx->snapshot_seq == seq)
+        {
+            snapshot->seq = seq;
+            return 1;
+        }
+        retry ++;
+    }
+
+    return 0;
+}
+#endif
+
+#ifdef FLEX_BTN_USING_TICKLESS
+#ifndef FLEX_BTN_USING_RULE_TABLE
+/**
+ * @brief The pressed event of the down stage at the specified scan count
+ * 
+ * @param target: button in the down stage, not in multiple click
+ * @param scan_cnt: scan count
+ * @return button event, FLEX_BTN_PRESS_NONE when none
+*/
+static uint8_t flex_button_down_event(flex_button_t *target, uint32_t scan_cnt)
+{
+    if (scan_cnt >= target->long_hold_start_tick)
+    {
+        return FLEX_BTN_PRESS_LONG_HOLD;
+    }
+    else if (scan_cnt >= target->long_press_start_tick)
+    {
+        return FLEX_BTN_PRESS_LONG_START;
+    }
+    else if (scan_cnt >= target->short_press_start_tick)
+    {
+        return FLEX_BTN_PRESS_SHORT_START;
+    }
+
+    return FLEX_BTN_PRESS_NONE;
+}
+
+/**
+ * @brief Scan cycles until the multiple click interval is exceeded
+ * 
+ * @param ctx: button context
+ * @param target: button in multiple click
+ * @param i: button index
+ * @return Scan cycles, at least 1
+*/
+static uint32_t flex_button_click_end_cnt(flex_button_ctx_t *ctx, flex_button_t *target, btn_index_t i)
+{
+    (void)ctx;
+    (void)i;
+
+    if (BTN_SCAN_CNT(ctx, target, i) > target->max_multiple_clicks_interval)
+    {
+        return 1;
+    }
+
+    return (uint32_t)target->max_multiple_clicks_interval + 1 - BTN_SCAN_CNT(ctx, target, i);
+}
+#endif
+
+#ifdef FLEX_BTN_USING_RULE_TABLE
+/**
+ * @brief Whether the rule of the button at the specified scan count changes anything
+*/
+static uint8_t flex_button_rule_effective(flex_button_ctx_t *ctx,
+    flex_button_t *target, btn_index_t i, uint32_t scan_cnt)
+{
+    const flex_button_rule_t *rule = flex_button_rule_match(ctx, target, i, scan_cnt);
+
+    if (!rule)
+    {
+        return 0;
+    }
+
+    return (rule->action != 0) || (rule->next != BTN_STATUS(ctx, target, i)) ||
+        (flex_button_rule_event(ctx, target, i, rule) != FLEX_BTN_RULE_EVENT_KEEP);
+}
+
+/**
+ * @brief Scan cycles until the rule of the button changes anything,
+ *        while the button level stays unchanged.
+ * 
+ * @param ctx: button context
+ * @param target: button
+ * @param i: button index
+ * @return Scan cycles, 0 when never
+*/
+static uint32_t flex_button_rule_next_cnt(flex_button_ctx_t *ctx, flex_button_t *target, btn_index_t i)
+{
+    uint8_t stage = BTN_STATUS(ctx, target, i);
+    uint32_t scan_cnt = BTN_SCAN_CNT(ctx, target, i);
+    const flex_button_rule_t *rule;
+    uint32_t next = 0;
+    uint32_t t;
+
+    if (stage == FLEX_BTN_STAGE_DEFAULT)
+    {
+        /* scan_cnt stays unchanged in the default stage */
+        return flex_button_rule_effective(ctx, target, i, scan_cnt) ? 1 : 0;
+    }
+
+    if (flex_button_rule_effective(ctx, target, i, scan_cnt + 1))
+    {
+        return 1;
+    }
+
+    /* The rules only change at their ticks */
+    for (rule = &ctx->rules[ctx->rule_first[stage]]; rule < &ctx->rules[ctx->rule_first[stage + 1]]; rule ++)
+    {
+        if (rule->tick == FLEX_BTN_RULE_TICK_NONE)
+        {
+            continue;
+        }
+
+        t = flex_button_rule_tick(target, rule->tick) + ((rule->cond & FLEX_BTN_RULE_EXCEED) ? 1 : 0);
+        if ((t > scan_cnt + 1) && ((next == 0) || (t - scan_cnt < next)) &&
+            flex_button_rule_effective(ctx, target, i, t))
+        {
+            next = t - scan_cnt;
+        }
+    }
+
+    return next;
+}
+#endif
+
+#if defined(FLEX_BTN_USING_TICKLESS) && defined(FLEX_BTN_USING_DEBOUNCE)
+/**
+ * @brief Check whether a debounce counter runs.
+ * 
+ * @param ctx: button context
+ * @return 1 when the raw state of a button differs from its debounced state
+*/
+static uint8_t flex_button_debouncing(flex_button_ctx_t *ctx)
+{
+    uint8_t w;
+    uint8_t k;
+
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        for (k = 0; k < FLEX_BTN_DEBOUNCE_CNT_BITS; k ++)
+        {
+            if (ctx->debounce_cnt[w][k])
+            {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+#endif
+
+/**
+ * @brief Scan cycles from the last processed scan to the next scan
+ *        that changes any button state, while the button levels stay unchanged.
+ * 
+ * @param ctx: button context
+ * @return Scan cycles, 0 when no button is waiting for anything
+*/
+static uint32_t flex_button_next_process_cnt(flex_button_ctx_t *ctx)
+{
+    btn_index_t i;
+    btn_index_t at;
+    uint8_t w;
+    uint32_t next = 0;
+    uint32_t cnt;
+    flex_button_t* target;
+    btn_type_t pending;
+
+#if defined(FLEX_BTN_USING_TICKLESS) && defined(FLEX_BTN_USING_DEBOUNCE)
+    if (flex_button_debouncing(ctx))
+    {
+        return 1; /* the levels are sampled again in the next scan */
+    }
+#endif
+
+    BTN_WALK_START(ctx, target, at);
+    for (w = FLEX_BTN_STATUS_WORDS; w-- > 0; )
+    {
+        pending = ctx->status_reg[w] | ctx->active_reg[w];
+
+        while (pending)
+        {
+            i = FLEX_BTN_MSB(pending);
+            pending &= ~((btn_type_t)1 << i);
+            i += w * FLEX_BTN_WORD_BITS;
+            BTN_WALK_TO(ctx, target, at, i);
+
+#ifdef FLEX_BTN_USING_RULE_TABLE
+            cnt = flex_button_rule_next_cnt(ctx, target, i);
+#else
+            cnt = 1; /* level changed or event to be cleared, next scan */
+
+            if ((BTN_STATUS(ctx, target, i) == FLEX_BTN_STAGE_DOWN) && BTN_IS_PRESSED(ctx, i))
+            {
+                if (BTN_CLICK_CNT(ctx, target, i) > 0)
+                {
+                    cnt = flex_button_click_end_cnt(ctx, target, i);
+                }
+                else
+                {
+                    uint32_t thresholds[3];
+                    uint32_t t;
+                    uint8_t k;
+                    uint8_t evt;
+
+                    thresholds[0] = target->short_press_start_tick;
+                    thresholds[1] = target->long_press_start_tick;
+                    thresholds[2] = target->long_hold_start_tick;
+
+                    /* The first scan count that reports a new pressed event */
+                    cnt = 0;
+                    for (k = 0; k < 4; k ++)
+                    {
+                        t = (k < 3) ? thresholds[k] : (uint32_t)BTN_SCAN_CNT(ctx, target, i) + 1;
+                        if (t <= BTN_SCAN_CNT(ctx, target, i))
+                        {
+                            continue;
+                        }
+
+                        evt = flex_button_down_event(target, t);
+                        if ((evt != FLEX_BTN_PRESS_NONE) && (evt != BTN_EVENT(ctx, target, i)) &&
+                            ((cnt == 0) || (t - BTN_SCAN_CNT(ctx, target, i) < cnt)))
+                        {
+                            cnt = t - BTN_SCAN_CNT(ctx, target, i);
+                        }
+                    }
+                }
+            }
+            else if ((BTN_STATUS(ctx, target, i) == FLEX_BTN_STAGE_MULTIPLE_CLICK) && !BTN_IS_PRESSED(ctx, i))
+            {
+                cnt = flex_button_click_end_cnt(ctx, target, i);
+            }
+#endif
+
+#ifdef FLEX_BTN_USING_REPEAT
+            if (BTN_REPEATING(ctx, target, i) && BTN_IS_PRESSED(ctx, i))
+            {
+                /* The next repeat */
+                if (target->repeat_cnt > 0)
+                {
+                    cnt = target->repeat_wait;
+                }
+                else if (target->repeat_delay_tick > BTN_SCAN_CNT(ctx, target, i))
+                {
+                    cnt = target->repeat_delay_tick - BTN_SCAN_CNT(ctx, target, i);
+                }
+                else
+                {
+                    cnt = 1;
+                }
+            }
+#endif
+
+            if ((cnt > 0) && ((next == 0) || (cnt < next)))
+            {
+                next = cnt;
+            }
+        }
+    }
+
+#ifdef FLEX_BTN_USING_COMBO
+    {
+        flex_button_combo_t *combo;
+
+        /* Combinations waiting for the last step held long enough */
+        for (combo = ctx->combo_head; combo != NULL; combo = combo->next)
+        {
+            if ((combo->step == combo->step_num) && (combo->hold_tick > combo->cnt))
+            {
+                cnt = combo->hold_tick - combo->cnt;
+                if ((next == 0) || (cnt < next))
+                {
+                    next = cnt;
+                }
+            }
+        }
+    }
+#endif
+
+    return next;
+}
+
+/**
+ * @brief Sample the levels in 'raw_reg', through the debounce, the same way
+ *        as flex_button_read samples the levels of a periodic scan.
+ * 
+ * @param ctx: button context
+*/
+static void flex_button_tickless_read(flex_button_ctx_t *ctx)
+{
+    btn_type_t pressed[FLEX_BTN_STATUS_WORDS];
+    uint8_t w;
+
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        pressed[w] = ((~ctx->raw_reg[w]) ^ ctx->logic_level[w]) & BTN_ENABLE(ctx)[w];
+    }
+
+    flex_button_sample(ctx, pressed);
+}
+
+/**
+ * @brief Handle the scans that change button state, until the specified scan.
+ * 
+ * @param ctx: button context
+ * @param elapsed: scan cycles since the last processed scan
+ * @param inclusive: 1 to also handle the scan at 'elapsed'
+ * @return Remaining scan cycles since the last processed scan
+*/
+static uint32_t flex_button_tickless_advance(flex_button_ctx_t *ctx, uint32_t elapsed, uint8_t inclusive)
+{
+    uint32_t next;
+
+    while (((next = flex_button_next_process_cnt(ctx)) != 0) &&
+           ((next < elapsed) || (inclusive && (next == elapsed))))
+    {
+        ctx->last_ts += next * FLEX_BTN_MS_PER_CNT;
+#ifdef FLEX_BTN_USING_DEBOUNCE
+        if (flex_button_debouncing(ctx))
+        {
+            flex_button_tickless_read(ctx); /* 'next' is 1, each scan samples */
+        }
+#endif
+        ctx->active_cnt = flex_button_process(ctx, (uint16_t)next);
+        elapsed -= next;
+    }
+
+    return elapsed;
+}
+
+/**
+ * @brief Process the scans without state change since the last processed
+ *        scan at once. 'last_ts' moves in whole scans, and the combination
+ *        intervals and the pressed time count them, as periodic scanning
+ *        does. The scan counts saturate, so a long idle time does not overflow.
+ * 
+ * @param ctx: button context
+ * @param elapsed: scan cycles since the last processed scan
+*/
+static void flex_button_tickless_process(flex_button_ctx_t *ctx, uint32_t elapsed)
+{
+    ctx->last_ts += elapsed * FLEX_BTN_MS_PER_CNT;
+    ctx->active_cnt = flex_button_process(ctx, elapsed > 0xFFFF ? 0xFFFF : (uint16_t)elapsed);
+}
+
+/**
+ * @brief Process the level changes in 'raw_reg' at the scan that samples them
+ * 
+ * @param ctx: button context
+*/
+static void flex_button_tickless_sample(flex_button_ctx_t *ctx)
+{
+    uint32_t elapsed = (ctx->sample_ts - ctx->last_ts) / FLEX_BTN_MS_PER_CNT;
+
+    elapsed = flex_button_tickless_advance(ctx, elapsed, 0);
+
+    flex_button_tickless_read(ctx);
+    flex_button_tickless_process(ctx, elapsed);
+    ctx->sample_pending = 0;
+}
+
+/**
+ * @brief Prepare 'raw_reg' for a level change at the specified time.
+ *        The change is sampled by the first scan after it, as periodic
+ *        scanning does, the earlier changes sampled by an earlier scan are
+ *        processed first. Changes sampled by the same scan are merged.
+ * 
+ * @param ctx: button context
+ * @param timestamp: the time of the level change, in milliseconds
+*/
+static void flex_button_tickless_edge(flex_button_ctx_t *ctx, uint32_t timestamp)
+{
+    uint32_t sample_ts = ctx->last_ts + FLEX_BTN_MS_PER_CNT;
+
+    if ((int32_t)(timestamp - ctx->last_ts) > 0)
+    {
+        sample_ts += (timestamp - ctx->last_ts) / FLEX_BTN_MS_PER_CNT * FLEX_BTN_MS_PER_CNT;
+    }
+
+    if (ctx->sample_pending && ((int32_t)(sample_ts - ctx->sample_ts) > 0))
+    {
+        flex_button_tickless_sample(ctx);
+    }
+
+    if (!ctx->sample_pending)
+    {
+#ifdef FLEX_BTN_USING_DEBOUNCE
+        /* The scans before the change still sample the old levels */
+        flex_button_tickless_advance(ctx, (sample_ts - ctx->last_ts) / FLEX_BTN_MS_PER_CNT, 0);
+#endif
+        ctx->sample_ts = sample_ts;
+        ctx->sample_pending = 1;
+    }
+}
+
+/**
+ * flex_button_ctx_notify_edge
+ * 
+ * @brief Report a button level change, can be called in the GPIO interrupt.
+ *        Only queues the level, button events are reported in
+ *        'flex_button_tickless_scan', so wake up the scan thread after this.
+ *        Up to FLEX_BTN_EDGE_QUEUE_SIZE changes are kept until the next scan,
+ *        after that only the last level and time are kept, and the shorter
+ *        presses and releases in between can be lost.
+ * 
+ * @param ctx: button context
+ * @param id: button id
+ * @param level: the new button level, same as 'usr_button_read' returns
+ * @param timestamp: the time of the level change, in milliseconds
+ * @return 0 on success,
+ *         1 when the queue is full, call 'flex_button_tickless_scan' now,
+ *         -1 when the button id is not registered
+*/
+int32_t flex_button_ctx_notify_edge(flex_button_ctx_t *ctx, uint8_t id, uint8_t level, uint32_t timestamp)
+{
+    btn_index_t i;
+    btn_index_t at;
+    flex_button_t* target;
+    uint16_t head = ctx->edge_queue.head;
+
+    BTN_WALK_START(ctx, target, at);
+    for (i = BTN_SLOTS(ctx); i-- > 0; )
+    {
+        if (!(ctx->mask[BTN_WORD(i)] & BTN_BIT(i)))
+        {
+            continue; /* not registered */
+        }
+        BTN_WALK_TO(ctx, target, at, i);
+
+        if (target->id == id)
+        {
+            break;
+        }
+    }
+
+    if (i >= BTN_SLOTS(ctx))
+    {
+        return -1;
+    }
+
+    if (level)
+    {
+        ctx->edge_level[BTN_WORD(i)] |= BTN_BIT(i);
+    }
+    else
+    {
+        ctx->edge_level[BTN_WORD(i)] &= ~BTN_BIT(i);
+    }
+
+    if ((uint16_t)(head - ctx->edge_queue.tail) >= FLEX_BTN_EDGE_QUEUE_SIZE)
+    {
+        /* The scan applies 'edge_level' at the time of the last change */
+        ctx->edge_ts = timestamp;
+        FLEX_BTN_MEMORY_BARRIER();
+        ctx->edge_overflow = 1;
+        return 1;
+    }
+
+    ctx->edge_queue.record[head & (FLEX_BTN_EDGE_QUEUE_SIZE - 1)].timestamp = timestamp;
+    ctx->edge_queue.record[head & (FLEX_BTN_EDGE_QUEUE_SIZE - 1)].index = i;
+    ctx->edge_queue.record[head & (FLEX_BTN_EDGE_QUEUE_SIZE - 1)].level = level ? 1 : 0;
+    FLEX_BTN_MEMORY_BARRIER();
+    ctx->edge_queue.head = head + 1;
+
+    return ((uint16_t)(head + 1 - ctx->edge_queue.tail) >= FLEX_BTN_EDGE_QUEUE_SIZE) ? 1 : 0;
+}
+
+/**
+ * flex_button_ctx_tickless_scan
+ * 
+ * @brief Handle the reported level changes and the expired deadlines.
+ *        Replaces the periodic 'flex_button_scan' in tickless mode, call it
+ *        after 'flex_button_notify_edge' and when the deadline from
+ *        'flex_button_next_deadline' expires.
+ *        Reports the same events as scanning every 1000 / FLEX_BTN_SCAN_FREQ_HZ ms,
+ *        as long as the edge queue does not overflow.
+ * 
+ * @param ctx: button context
+ * @param now: current time, in milliseconds
+ * @return Activated button count
+*/
+uint8_t flex_button_ctx_tickless_scan(flex_button_ctx_t *ctx, uint32_t now)
+{
+    uint32_t elapsed;
+    uint16_t tail;
+    uint8_t w;
+#ifdef FLEX_BTN_USING_EVENT_BATCH
+    flex_button_batch_event_t batch[FLEX_BTN_EVENT_BATCH_SIZE];
+#endif
+
+    BTN_STATS_SCAN_BEGIN(ctx);
+    BTN_BATCH_BEGIN(ctx, batch);
+    BTN_SNAPSHOT_BEGIN(ctx);
+    for (tail = ctx->edge_queue.tail; tail != ctx->edge_queue.head; tail ++)
+    {
+        btn_index_t i;
+
+        FLEX_BTN_MEMORY_BARRIER();
+        i = ctx->edge_queue.record[tail & (FLEX_BTN_EDGE_QUEUE_SIZE - 1)].index;
+        flex_button_tickless_edge(ctx, ctx->edge_queue.record[tail & (FLEX_BTN_EDGE_QUEUE_SIZE - 1)].timestamp);
+        if (ctx->edge_queue.record[tail & (FLEX_BTN_EDGE_QUEUE_SIZE - 1)].level)
+        {
+            ctx->raw_reg[BTN_WORD(i)] |= BTN_BIT(i);
+        }
+        else
+        {
+            ctx->raw_reg[BTN_WORD(i)] &= ~BTN_BIT(i);
+        }
+        FLEX_BTN_MEMORY_BARRIER();
+        ctx->edge_queue.tail = tail + 1;
+    }
+
+    if (ctx->edge_overflow)
+    {
+        ctx->edge_overflow = 0;
+        FLEX_BTN_MEMORY_BARRIER();
+        flex_button_tickless_edge(ctx, ctx->edge_ts);
+        for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+        {
+            ctx->raw_reg[w] = ctx->edge_level[w] & ctx->mask[w];
+        }
+    }
+
+    /* The scan that samples the last changes is due */
+    if (ctx->sample_pending && ((int32_t)(now - ctx->sample_ts) >= 0))
+    {
+        flex_button_tickless_sample(ctx);
+    }
+
+    elapsed = ((int32_t)(now - ctx->last_ts) > 0) ?
+        (now - ctx->last_ts) / FLEX_BTN_MS_PER_CNT : 0;
+    elapsed = flex_button_tickless_advance(ctx, elapsed, 1);
+    if (elapsed > 0)
+    {
+        flex_button_tickless_process(ctx, elapsed);
+    }
+    BTN_SNAPSHOT_END(ctx);
+
+    return BTN_STATS_SCAN_END(ctx, BTN_BATCH_END(ctx, ctx->active_cnt));
+}
+
+/**
+ * flex_button_ctx_next_deadline
+ * 
+ * @brief Get the time at which 'flex_button_tickless_scan' needs to be called,
+ *        if no button level changes before. The system can sleep until then.
+ * 
+ * @param ctx: button context
+ * @param timestamp: the deadline, in milliseconds
+ * @return 1 when there is a deadline, 0 when waiting for level changes only
+*/
+uint8_t flex_button_ctx_next_deadline(flex_button_ctx_t *ctx, uint32_t *timestamp)
+{
+    uint32_t next = flex_button_next_process_cnt(ctx);
+
+    /* The scan that samples the queued level changes */
+    if (ctx->sample_pending &&
+        ((next == 0) || ((int32_t)(ctx->sample_ts - ctx->last_ts - next * FLEX_BTN_MS_PER_CNT) < 0)))
+    {
+        *timestamp = ctx->sample_ts;
+        return 1;
+    }
+
+    if (next == 0)
+    {
+        return 0;
+    }
+
+    *timestamp = ctx->last_ts + next * FLEX_BTN_MS_PER_CNT;
+
+    return 1;
+}
+#endif
+
+/**
+ * The API below works on the default context.
+*/
+flex_button_ctx_t *flex_button_default_ctx(void)
+{
+    return &g_btn_ctx;
+}
+
+#ifdef FLEX_BTN_USING_ARRAY_STORAGE
+int32_t flex_button_array_init(flex_button_t *buttons, uint16_t num)
+{
+    return flex_button_ctx_array_init(&g_btn_ctx, buttons, num);
+}
+#endif
+
+int32_t flex_button_register(flex_button_t *button)
+{
+    return flex_button_ctx_register(&g_btn_ctx, button);
+}
+
+#ifdef FLEX_BTN_USING_UNREGISTER
+int32_t flex_button_unregister(flex_button_t *button)
+{
+    return flex_button_ctx_unregister(&g_btn_ctx, button);
+}
+
+int32_t flex_button_enable(flex_button_t *button, uint8_t enable)
+{
+    return flex_button_ctx_enable(&g_btn_ctx, button, enable);
+}
+
+void flex_button_enable_mask(const btn_type_t *enable)
+{
+    flex_button_ctx_enable_mask(&g_btn_ctx, enable);
+}
+#endif
+
+#ifdef FLEX_BTN_USING_GROUP_READ
+int32_t flex_button_group_register(flex_button_group_t *group)
+{
+    return flex_button_ctx_group_register(&g_btn_ctx, group);
+}
+#endif
+
+flex_button_event_t flex_button_event_read(flex_button_t* button)
+{
+    return flex_button_ctx_event_read(&g_btn_ctx, button);
+}
+
+#ifdef FLEX_BTN_USING_TIMESTAMP
+uint8_t flex_button_scan(uint32_t now)
+{
+    return flex_button_ctx_scan(&g_btn_ctx, now);
+}
+#else
+uint8_t flex_button_scan(void)
+{
+    return flex_button_ctx_scan(&g_btn_ctx);
+}
+#endif
+
+#ifdef FLEX_BTN_USING_EVENT_BATCH
+void flex_button_batch_handler(flex_button_batch_handler_t handler, void *arg)
+{
+    flex_button_ctx_batch_handler(&g_btn_ctx, handler, arg);
+}
+#endif
+
+#ifdef FLEX_BTN_USING_TRACE
+void flex_button_trace_hook(flex_button_trace_hook_t hook, void *arg)
+{
+    flex_button_ctx_trace_hook(&g_btn_ctx, hook, arg);
+}
+
+#ifdef FLEX_BTN_USING_TIMESTAMP
+uint8_t flex_button_replay(const btn_type_t *pressed, uint32_t now)
+{
+    return flex_button_ctx_replay(&g_btn_ctx, pressed, now);
+}
+#else
+uint8_t flex_button_replay(const btn_type_t *pressed)
+{
+    return flex_button_ctx_replay(&g_btn_ctx, pressed);
+}
+#endif
+#endif
+
+#ifdef FLEX_BTN_USING_EVENT_QUEUE
+uint8_t flex_button_event_pop(flex_button_event_record_t *record)
+{
+    return flex_button_ctx_event_pop(&g_btn_ctx, record);
+}
+
+uint32_t flex_button_event_overflow(void)
+{
+    return flex_button_ctx_event_overflow(&g_btn_ctx);
+}
+#endif
+
+#ifdef FLEX_BTN_USING_RULE_TABLE
+int32_t flex_button_rules_set(const flex_button_rule_t *rules, uint8_t num)
+{
+    return flex_button_ctx_rules_set(&g_btn_ctx, rules, num);
+}
+#endif
+
+#ifdef FLEX_BTN_USING_COMBO
+int32_t flex_button_combo_register(flex_button_combo_t *combo)
+{
+    return flex_button_ctx_combo_register(&g_btn_ctx, combo);
+}
+#endif
+
+#ifdef FLEX_BTN_USING_ENCODER
+int32_t flex_button_encoder_register(flex_button_encoder_t *encoder)
+{
+    return flex_button_ctx_encoder_register(&g_btn_ctx, encoder);
+}
+#endif
+
+#ifdef FLEX_BTN_USING_STATS
+void flex_button_stats_get(flex_button_stats_t *stats)
+{
+    flex_button_ctx_stats_get(&g_btn_ctx, stats);
+}
+
+void flex_button_stats_reset(void)
+{
+    flex_button_ctx_stats_reset(&g_btn_ctx);
+}
+#endif
+
+#ifdef FLEX_BTN_USING_SNAPSHOT
+uint8_t flex_button_snapshot(flex_button_snapshot_t *snapshot)
+{
+    return flex_button_ctx_snapshot(&g_btn_ctx, snapshot);
+}
+#endif
+
+#ifdef FLEX_BTN_USING_TICKLESS
+int32_t flex_button_notify_edge(uint8_t id, uint8_t level, uint32_t timestamp)
+{
+    return flex_button_ctx_notify_edge(&g_btn_ctx, id, level, timestamp);
+}
+
+uint8_t flex_button_tickless_scan(uint32_t now)
+{
+    return flex_button_ctx_tickless_scan(&g_btn_ctx, now);
+}
+
+uint8_t flex_button_next_deadline(uint32_t *timestamp)
+{
+    return flex_button_ctx_next_deadline(&g_btn_ctx, timestamp);
+}
+#endif
@@ -34,13 +34,187 @@
 #include "stdint.h"
 
 #define FLEX_BTN_SCAN_FREQ_HZ 50 // How often flex_button_scan () is called
+
+#ifdef FLEX_BTN_USING_TIMESTAMP
+#define FLEX_MS_TO_SCAN_CNT(ms) (ms) // Button timing is in milliseconds
+#else
 #define FLEX_MS_TO_SCAN_CNT(ms) (ms / (1000 / FLEX_BTN_SCAN_FREQ_HZ))
+#endif
 
 /* Multiple clicks interval, default 300ms */
 #define MAX_MULTIPLE_CLICKS_INTERVAL (FLEX_MS_TO_SCAN_CNT(300))
 
+/**
+ * Optional features, all disabled by default.
+ * Define them here or in the compiler options to enable.
+ *
+ * FLEX_BTN_USING_GROUP_READ
+ *     Read several buttons with one 'usr_group_read' call,
+ *     see flex_button_group_t.
+ *
+ * FLEX_BTN_USING_TICKLESS
+ *     Report level changes from the GPIO interrupt with flex_button_notify_edge,
+ *     and scan only when needed with flex_button_tickless_scan, instead of
+ *     calling flex_button_scan periodically.
+ *     FLEX_BTN_EDGE_QUEUE_SIZE sets the level changes kept until the next
+ *     tickless scan, a power of 2, default 8.
+ *     The sampled levels are debounced as in periodic scanning, the scans run
+ *     one by one while a debounce counter runs. Can not be used with
+ *     FLEX_BTN_USING_TRACE, which records every scan.
+ *
+ * FLEX_BTN_USING_TIMESTAMP
+ *     flex_button_scan takes the current time in milliseconds, and all button
+ *     timing is in milliseconds instead of scan counts, so it does not drift
+ *     when the scan is delayed, and the scan period can change at runtime.
+ *
+ * FLEX_BTN_USING_DEBOUNCE
+ *     Debounce each button for 'debounce_tick' scans, all buttons are
+ *     debounced together with vertical counters.
+ *     FLEX_BTN_DEBOUNCE_CNT_BITS sets the maximum 'debounce_tick', default 3 (7 scans).
+ *
+ * FLEX_BTN_USING_EVENT_QUEUE
+ *     Queue the button events instead of calling 'cb' in the scan, the
+ *     application takes them with flex_button_event_pop in its own thread.
+ *     FLEX_BTN_EVENT_QUEUE_SIZE sets the queue length, a power of 2, default 16.
+ *
+ * FLEX_BTN_USING_EVENT_BATCH
+ *     Collect the button events of each scan, and pass them to one handler
+ *     at the end of the scan, instead of calling 'cb' for each event,
+ *     see flex_button_batch_handler. Can not be used with FLEX_BTN_USING_EVENT_QUEUE.
+ *     FLEX_BTN_EVENT_BATCH_SIZE sets the events per handler call, default 16.
+ *
+ * FLEX_BTN_USING_ARRAY_STORAGE
+ *     Buttons are kept in a user array set by flex_button_array_init, the bit
+ *     index of each button is its position in the array. The scan state of
+ *     all buttons is kept in compact tables of the context, not in the buttons,
+ *     and the buttons have no 'next', 'scan_cnt' and 'status'. 'event' and
+ *     'click_cnt' of a button are only updated before its callback, read the
+ *     event with flex_button_ctx_event_read.
+ *
+ * FLEX_BTN_USING_UNREGISTER
+ *     Remove buttons with flex_button_unregister, and disable or enable them
+ *     at runtime with flex_button_enable and flex_button_enable_mask.
+ *
+ * FLEX_BTN_USING_TRACE
+ *     Pass the pressing state of each scan to a hook, e.g. to record the scans
+ *     with flexible_button_trace.c, and replay them with flex_button_ctx_replay.
+ *
+ * FLEX_BTN_USING_STATS
+ *     Count the scans, the callbacks and the events, see flex_button_stats_get.
+ *     Define FLEX_BTN_CYCLES() to a free-running cycle counter of the target,
+ *     e.g. DWT->CYCCNT on Cortex-M, to also measure the time of the scans and
+ *     the callbacks.
+ *
+ * FLEX_BTN_USING_RULE_TABLE
+ *     Run the gestures from a table of flex_button_rule_t instead of the
+ *     built-in state machine. The default table reports the same events,
+ *     a product can set its own with flex_button_rules_set. It makes the
+ *     gestures configurable, it is not faster, the rules of the button stage
+ *     are interpreted in each scan of a pressed or clicked button.
+ *
+ * FLEX_BTN_USING_COMBO
+ *     Detect button combinations, e.g. two buttons held together, or buttons
+ *     pressed one after another, see flex_button_combo_t. While the last step
+ *     is held for 'hold_tick', the events of its buttons are held, they are
+ *     dropped when the combination is reported, and reported when it is not.
+ *
+ * FLEX_BTN_USING_REPEAT
+ *     Auto-repeat while a button is held, e.g. volume or scroll keys, a button
+ *     with 'repeat_rate_tick' reports FLEX_BTN_PRESS_REPEAT events instead of
+ *     the short press, long press and long hold start events, and one
+ *     FLEX_BTN_PRESS_REPEAT_UP instead of their up events.
+ *
+ * FLEX_BTN_USING_ENCODER
+ *     Decode quadrature rotary encoders in flex_button_scan, and report their
+ *     detents as FLEX_BTN_PRESS_STEP events, see flex_button_encoder_t.
+ *
+ * FLEX_BTN_USING_SNAPSHOT
+ *     Let other threads copy the scan state of all buttons with
+ *     flex_button_snapshot, without locks and without blocking the scan.
+ *     FLEX_BTN_SNAPSHOT_RETRY sets the copies tried when a scan changed the
+ *     state during the copy, default 4. While a scan runs, the reader calls
+ *     FLEX_BTN_SNAPSHOT_WAIT(), empty by default, define it as a thread yield
+ *     on an RTOS, up to FLEX_BTN_SNAPSHOT_SPIN times, default 100000.
+*/
+
+typedef uint32_t btn_type_t;
+
+/**
+ * FLEX_BTN_STATUS_WORDS
+ * 
+ * Number of btn_type_t words of the button status register,
+ * each word holds FLEX_BTN_WORD_BITS buttons. Default 1, up to 32 buttons.
+*/
+#ifndef FLEX_BTN_STATUS_WORDS
+#define FLEX_BTN_STATUS_WORDS 1
+#endif
+
+#define FLEX_BTN_WORD_BITS (sizeof(btn_type_t) * 8)
+#define FLEX_BTN_MAX_NUM   (FLEX_BTN_STATUS_WORDS * FLEX_BTN_WORD_BITS)
+
+/**
+ * FLEX_BTN_USING_BTN_TABLE
+ * 
+ * Set internally. The list mode keeps the button of each bit index in a
+ * table, when there are several status words, or when unregistered buttons
+ * leave the list out of the bit index order. Otherwise the scan walks the
+ * button list, last registered first, from the highest bit index down.
+*/
+#if !defined(FLEX_BTN_USING_ARRAY_STORAGE) && \
+    ((FLEX_BTN_STATUS_WORDS > 1) || defined(FLEX_BTN_USING_UNREGISTER))
+#define FLEX_BTN_USING_BTN_TABLE
+#endif
+
+/* Button index type, fits FLEX_BTN_MAX_NUM */
+#if FLEX_BTN_STATUS_WORDS < 8
+typedef uint8_t btn_index_t;
+#else
+typedef uint16_t btn_index_t;
+#endif
+
+#ifndef FLEX_BTN_DEBOUNCE_CNT_BITS
+#define FLEX_BTN_DEBOUNCE_CNT_BITS 3 // debounce_tick up to 7 scans
+#endif
+
+#ifndef FLEX_BTN_EVENT_QUEUE_SIZE
+#define FLEX_BTN_EVENT_QUEUE_SIZE 16
+#endif
+
+#ifndef FLEX_BTN_EDGE_QUEUE_SIZE
+#define FLEX_BTN_EDGE_QUEUE_SIZE 8
+#endif
+
+#ifndef FLEX_BTN_EVENT_BATCH_SIZE
+#define FLEX_BTN_EVENT_BATCH_SIZE 16
+#endif
+
+#ifndef FLEX_BTN_SNAPSHOT_RETRY
+#define FLEX_BTN_SNAPSHOT_RETRY 4
+#endif
+
+#ifndef FLEX_BTN_SNAPSHOT_SPIN
+#define FLEX_BTN_SNAPSHOT_SPIN 100000
+#endif
+
+#ifndef FLEX_BTN_SNAPSHOT_WAIT
+#define FLEX_BTN_SNAPSHOT_WAIT()
+#endif
+
+#ifndef FLEX_BTN_CYCLES
+#define FLEX_BTN_CYCLES() 0 // No cycle counter, time statistics stay 0
+#endif
+
+/* Latency histogram bins, latency 0 and one bin per bit of scan_cnt */
+#define FLEX_BTN_STATS_LATENCY_BINS 17
+
+/* Signed 'step' of a queued or batched FLEX_BTN_PRESS_STEP, stored in 'click_cnt' as two's complement */
+#define FLEX_BTN_EVENT_STEP(e) ((int16_t)(e)->click_cnt)
+
 typedef void (*flex_button_response_callback)(void*);
 
+/* Receives the pressing state of the registered buttons in each scan, FLEX_BTN_STATUS_WORDS words */
+typedef void (*flex_button_trace_hook_t)(void *arg, const btn_type_t *pressed);
+
 typedef enum
 {
     FLEX_BTN_PRESS_DOWN = 0,
@@ -53,10 +227,432 @@ typedef enum
     FLEX_BTN_PRESS_LONG_UP,
     FLEX_BTN_PRESS_LONG_HOLD,
     FLEX_BTN_PRESS_LONG_HOLD_UP,
+    FLEX_BTN_PRESS_COMBO,
+    FLEX_BTN_PRESS_REPEAT,
+    FLEX_BTN_PRESS_STEP, // Encoder step, negative counterclockwise, see FLEX_BTN_EVENT_STEP
+    FLEX_BTN_PRESS_REPEAT_UP,
     FLEX_BTN_PRESS_MAX,
     FLEX_BTN_PRESS_NONE,
 } flex_button_event_t;
 
+enum FLEX_BTN_STAGE
+{
+    FLEX_BTN_STAGE_DEFAULT = 0,
+    FLEX_BTN_STAGE_DOWN    = 1,
+    FLEX_BTN_STAGE_MULTIPLE_CLICK = 2
+};
+
+#ifdef FLEX_BTN_USING_RULE_TABLE
+/* Stages of a rule table, 'status' of flex_button_t has 3 bits */
+#define FLEX_BTN_RULE_STAGE_NUM     8
+
+/* flex_button_rule_t 'cond' */
+#define FLEX_BTN_RULE_PRESSED       0x01 // button is pressed
+#define FLEX_BTN_RULE_RELEASED      0x02 // button is released
+#define FLEX_BTN_RULE_CLICKED       0x04 // click_cnt > 0
+#define FLEX_BTN_RULE_NOT_CLICKED   0x08 // click_cnt == 0
+#define FLEX_BTN_RULE_EXCEED        0x10 // scan_cnt > tick, instead of scan_cnt >= tick
+#define FLEX_BTN_RULE_ONCE          0x20 // no event if the button event is already 'event'
+
+/* flex_button_rule_t 'tick' */
+#define FLEX_BTN_RULE_TICK_NONE     0
+#define FLEX_BTN_RULE_TICK_SHORT    1 // short_press_start_tick
+#define FLEX_BTN_RULE_TICK_LONG     2 // long_press_start_tick
+#define FLEX_BTN_RULE_TICK_HOLD     3 // long_hold_start_tick
+#define FLEX_BTN_RULE_TICK_CLICK    4 // max_multiple_clicks_interval
+
+/* flex_button_rule_t 'event', besides flex_button_event_t */
+#define FLEX_BTN_RULE_EVENT_CLICKS  FLEX_BTN_PRESS_MAX // click, double click or repeat click by click_cnt
+#define FLEX_BTN_RULE_EVENT_KEEP    0xFF               // event unchanged, FLEX_BTN_PRESS_NONE clears it
+
+/* flex_button_rule_t 'action' */
+#define FLEX_BTN_RULE_START         0x01 // scan_cnt and click_cnt = 0, before the event
+#define FLEX_BTN_RULE_RESET_SCAN    0x02 // scan_cnt = 0, after the event
+#define FLEX_BTN_RULE_RESET_CLICK   0x04 // click_cnt = 0, after the event
+#define FLEX_BTN_RULE_INC_CLICK     0x08 // click_cnt ++, after the event
+
+/**
+ * flex_button_rule_t
+ * 
+ * @brief Gesture rule, with FLEX_BTN_USING_RULE_TABLE
+ *        In each scan, the first rule of the button stage whose conditions
+ *        are all met is applied, the other rules are skipped.
+ *        The rules of a table are grouped by stage, in ascending stage order.
+ * 
+ * @member stage
+ *         The stage the rule applies to, up to FLEX_BTN_RULE_STAGE_NUM - 1.
+ * 
+ * @member cond
+ *         FLEX_BTN_RULE_PRESSED etc. Without PRESSED and RELEASED, any level,
+ *         without CLICKED and NOT_CLICKED, any click count.
+ * 
+ * @member tick
+ *         scan_cnt must reach this tick of the button, FLEX_BTN_RULE_TICK_NONE for any.
+ * 
+ * @member event
+ *         The event reported, FLEX_BTN_RULE_EVENT_CLICKS or FLEX_BTN_RULE_EVENT_KEEP.
+ * 
+ * @member action
+ *         FLEX_BTN_RULE_START etc.
+ * 
+ * @member next
+ *         The stage after the rule is applied.
+ * 
+*/
+typedef struct flex_button_rule
+{
+    uint8_t stage;
+    uint8_t cond;
+    uint8_t tick;
+    uint8_t event;
+    uint8_t action;
+    uint8_t next;
+} flex_button_rule_t;
+#endif
+
+/**
+ * flex_button_event_record_t
+ * 
+ * @brief Queued button event, with FLEX_BTN_USING_EVENT_QUEUE
+ * 
+ * @member timestamp
+ *         The time of the scan that reported the event.
+ *         Scan count, or milliseconds with FLEX_BTN_USING_TIMESTAMP or FLEX_BTN_USING_TICKLESS.
+ * 
+ * @member click_cnt
+ *         'click_cnt' of the button when the event was reported,
+ *         'repeat_cnt' for FLEX_BTN_PRESS_REPEAT and FLEX_BTN_PRESS_REPEAT_UP,
+ *         'step' for FLEX_BTN_PRESS_STEP, as two's complement,
+ *         read it with FLEX_BTN_EVENT_STEP().
+ * 
+ * @member id
+ *         Button id, or encoder id for FLEX_BTN_PRESS_STEP.
+ * 
+ * @member event
+ *         Button event, flex_button_event_t.
+ * 
+ * @member velocity
+ *         Only with FLEX_BTN_USING_ENCODER, 'velocity' for FLEX_BTN_PRESS_STEP.
+ * 
+*/
+typedef struct flex_button_event_record
+{
+    uint32_t timestamp;
+    uint16_t click_cnt;
+    uint8_t  id;
+    uint8_t  event;
+#ifdef FLEX_BTN_USING_ENCODER
+    int16_t  velocity;
+#endif
+} flex_button_event_record_t;
+
+/**
+ * flex_button_batch_event_t
+ * 
+ * @brief Button event passed to the batch handler, with FLEX_BTN_USING_EVENT_BATCH
+ * 
+ * @member click_cnt
+ *         'click_cnt' of the button when the event was reported,
+ *         'repeat_cnt' for FLEX_BTN_PRESS_REPEAT and FLEX_BTN_PRESS_REPEAT_UP,
+ *         'step' for FLEX_BTN_PRESS_STEP, as two's complement,
+ *         read it with FLEX_BTN_EVENT_STEP().
+ * 
+ * @member id
+ *         Button id, combination id for FLEX_BTN_PRESS_COMBO,
+ *         or encoder id for FLEX_BTN_PRESS_STEP.
+ * 
+ * @member event
+ *         Button event, flex_button_event_t.
+ * 
+ * @member velocity
+ *         Only with FLEX_BTN_USING_ENCODER, 'velocity' for FLEX_BTN_PRESS_STEP.
+ * 
+*/
+typedef struct flex_button_batch_event
+{
+    uint16_t click_cnt;
+    uint8_t  id;
+    uint8_t  event;
+#ifdef FLEX_BTN_USING_ENCODER
+    int16_t  velocity;
+#endif
+} flex_button_batch_event_t;
+
+/* Receives the events of a scan, in the order they are reported */
+typedef void (*flex_button_batch_handler_t)(void *arg, const flex_button_batch_event_t *events, uint16_t num);
+
+/**
+ * flex_button_stats_t
+ * 
+ * @brief Scan statistics, with FLEX_BTN_USING_STATS
+ *        The cycles are measured with FLEX_BTN_CYCLES().
+ * 
+ * @member scan_cnt
+ *         Number of scans.
+ * 
+ * @member scan_cycles_max, scan_cycles_avg
+ *         Worst and average cycles per scan, including the callbacks.
+ * 
+ * @member cb_cnt, cb_cycles_max, cb_cycles_total
+ *         Number of callbacks, and the worst and total cycles spent in them.
+ * 
+ * @member event_cnt
+ *         Number of events of each flex_button_event_t.
+ * 
+ * @member latency_hist
+ *         Latency of each event, from the last change of the sampled level of
+ *         its button, before debouncing, to the report, in 'scan_cnt' units.
+ *         A combination is measured from the last change of the buttons of its
+ *         last step, an encoder step is reported in the scan that decodes it.
+ *         latency_hist[0] counts the latency 0, latency_hist[k] counts the
+ *         latencies of 2^(k-1) to 2^k - 1, the last bin also the longer ones.
+ * 
+*/
+typedef struct flex_button_stats
+{
+    uint32_t scan_cnt;
+    uint32_t scan_cycles_max;
+    uint32_t scan_cycles_avg;
+
+    uint32_t cb_cnt;
+    uint32_t cb_cycles_max;
+    uint32_t cb_cycles_total;
+
+    uint32_t event_cnt[FLEX_BTN_PRESS_MAX];
+    uint32_t latency_hist[FLEX_BTN_STATS_LATENCY_BINS];
+} flex_button_stats_t;
+
+/**
+ * flex_button_snapshot_button_t
+ * 
+ * @brief Scan state of one button in a snapshot, with FLEX_BTN_USING_SNAPSHOT
+ * 
+ * @member scan_cnt, click_cnt, id, event, status
+ *         Same as the members of flex_button_t, 'event' is FLEX_BTN_PRESS_NONE
+ *         for an index without a registered button.
+ * 
+*/
+typedef struct flex_button_snapshot_button
+{
+    uint16_t scan_cnt;
+    uint16_t click_cnt;
+    uint8_t  id;
+    uint8_t  event;
+    uint8_t  status;
+} flex_button_snapshot_button_t;
+
+/**
+ * flex_button_snapshot_t
+ * 
+ * @brief Consistent copy of the scan state of all buttons, with FLEX_BTN_USING_SNAPSHOT
+ *        Taken between two scans, see flex_button_snapshot.
+ * 
+ * @member seq
+ *         Sequence of the copied state, it changes with each scan, a snapshot
+ *         with the same 'seq' as the previous one has the same state.
+ * 
+ * @member status_reg, active_reg
+ *         Pressed and activated buttons, bit i is the button at index i,
+ *         same as the members of flex_button_ctx_t.
+ * 
+ * @member mask, enable
+ *         Registered and enabled buttons, bit i is the button at index i.
+ * 
+ * @member button_num
+ *         Number of button indexes copied to 'button', registered or not.
+ * 
+ * @member button
+ *         Scan state of the button at each index.
+ * 
+*/
+typedef struct flex_button_snapshot
+{
+    uint32_t seq;
+
+    btn_type_t status_reg[FLEX_BTN_STATUS_WORDS];
+    btn_type_t active_reg[FLEX_BTN_STATUS_WORDS];
+    btn_type_t mask[FLEX_BTN_STATUS_WORDS];
+    btn_type_t enable[FLEX_BTN_STATUS_WORDS];
+
+    btn_index_t button_num;
+    flex_button_snapshot_button_t button[FLEX_BTN_MAX_NUM];
+} flex_button_snapshot_t;
+
+/**
+ * flex_button_group_t
+ * 
+ * @brief Button group data structure
+ *        A group reads the raw level of several buttons at once,
+ *        e.g. all buttons on one GPIO port are read by one port register read.
+ * 
+ * @member next
+ *         Internal use.
+ *         One-way linked list, pointing to the next group.
+ * 
+ * @member usr_group_read
+ *         User function is used to read the raw level of all buttons in the group.
+ *         Each bit represents a button, see 'group_bit' of flex_button_t.
+ * 
+ * @member value
+ *         Internal use, user read-only.
+ *         The value returned by 'usr_group_read' in the current scan cycle.
+ * 
+*/
+typedef struct flex_button_group
+{
+    struct flex_button_group* next;
+
+    btn_type_t (*usr_group_read)(void *);
+
+    btn_type_t value;
+} flex_button_group_t;
+
+/**
+ * flex_button_combo_t
+ * 
+ * @brief Button combination data structure, with FLEX_BTN_USING_COMBO
+ *        A combination is a sequence of steps, each step is a set of buttons
+ *        pressed together. A step is entered when all of its buttons are pressed,
+ *        and the combination is reported when the last step is held for 'hold_tick'.
+ *        A button pressed that is not in the next step restarts the combination.
+ *        e.g. A+B held 2s: one step {A, B}, 'hold_tick' 2s.
+ *             A, B, A: three steps {A}, {B}, {A}, 'hold_tick' 0.
+ *        While the last step is held for 'hold_tick', the events of its
+ *        buttons are held, e.g. the FLEX_BTN_PRESS_SHORT_START of A and B
+ *        while A+B is held for 2s. When the combination is reported, the held
+ *        events are dropped, and the buttons report nothing more until they
+ *        are released and idle. When the step is left first, e.g. A+B released
+ *        before 'hold_tick', the held events are reported at that scan, one
+ *        of each event in the order of flex_button_event_t, before the events
+ *        of the release. The events before the last step is entered, e.g. the
+ *        FLEX_BTN_PRESS_DOWN of A pressed before B, stay reported.
+ *        Below are members that need to user init before registering.
+ * 
+ * @member next
+ *         Internal use.
+ *         One-way linked list, pointing to the next combination.
+ * 
+ * @member steps
+ *         Buttons of each step, FLEX_BTN_STATUS_WORDS words per step,
+ *         bit i is the button at bit i of 'status_reg'. Requires user configuration.
+ * 
+ * @member cb
+ *         Combination callback function, the argument is the combination.
+ *         With FLEX_BTN_USING_EVENT_QUEUE or FLEX_BTN_USING_EVENT_BATCH, a
+ *         FLEX_BTN_PRESS_COMBO event with the combination 'id' is queued or
+ *         collected instead.
+ * 
+ * @member interval_tick
+ *         Maximum time from a step to the next one.
+ *         Need to use FLEX_MS_TO_SCAN_CNT to convert milliseconds into scan cnts.
+ * 
+ * @member hold_tick
+ *         Time to hold the last step, 0 to report it when pressed.
+ *         Need to use FLEX_MS_TO_SCAN_CNT to convert milliseconds into scan cnts.
+ * 
+ * @member cnt
+ *         Internal use.
+ *         Scan cnts since the last step entered.
+ * 
+ * @member id
+ *         Combination id. Requires user configuration.
+ * 
+ * @member step_num
+ *         Number of steps. Requires user configuration.
+ * 
+ * @member step
+ *         Internal use.
+ *         Number of steps entered, 'step_num' + 1 when reported.
+ * 
+*/
+typedef struct flex_button_combo
+{
+    struct flex_button_combo* next;
+
+    const btn_type_t *steps;
+    flex_button_response_callback cb;
+
+    uint16_t interval_tick;
+    uint16_t hold_tick;
+    uint16_t cnt;
+
+    uint8_t id;
+    uint8_t step_num;
+    uint8_t step;
+} flex_button_combo_t;
+
+/**
+ * flex_button_encoder_t
+ * 
+ * @brief Rotary encoder data structure, with FLEX_BTN_USING_ENCODER
+ *        The A/B phases are read in each flex_button_scan, so the scan period
+ *        must be shorter than one phase state at the fastest rotation.
+ *        Not read by flex_button_tickless_scan and flex_button_replay.
+ *        Below are members that need to user init before registering.
+ * 
+ * @member next
+ *         Internal use.
+ *         One-way linked list, pointing to the next encoder.
+ * 
+ * @member usr_encoder_read
+ *         User function is used to read the phases, bit 0 is A and bit 1 is B.
+ *         A leads B when turned clockwise.
+ * 
+ * @member cb
+ *         Encoder callback function, the argument is the encoder.
+ *         Called with FLEX_BTN_PRESS_STEP in the scans that turn a detent.
+ *         With FLEX_BTN_USING_EVENT_QUEUE or FLEX_BTN_USING_EVENT_BATCH, the
+ *         event is queued or collected instead.
+ * 
+ * @member cnt
+ *         Internal use.
+ *         Scan cnts since the last detent, up to one second.
+ * 
+ * @member position
+ *         Internal use, user read-only.
+ *         Detents turned since registered, clockwise positive.
+ * 
+ * @member step
+ *         Internal use, user read-only.
+ *         Detents turned in the scan of the event, clockwise positive.
+ * 
+ * @member velocity
+ *         Internal use, user read-only.
+ *         Detents per second in the scan of the event, clockwise positive.
+ * 
+ * @member id
+ *         Encoder id. Requires user configuration.
+ * 
+ * @member steps_per_detent
+ *         Phase changes per detent, usually 4, or 2 or 1. 0 means 4.
+ * 
+ * @member phase
+ *         Internal use.
+ *         The phases read in the last scan.
+ * 
+ * @member sub_step
+ *         Internal use.
+ *         Phase changes since the last detent.
+ * 
+*/
+typedef struct flex_button_encoder
+{
+    struct flex_button_encoder* next;
+
+    uint8_t (*usr_encoder_read)(void *);
+    flex_button_response_callback cb;
+
+    uint16_t cnt;
+    int16_t position;
+    int16_t step;
+    int16_t velocity;
+
+    uint8_t id;
+    uint8_t steps_per_detent;
+    uint8_t phase;
+    int8_t sub_step;
+} flex_button_encoder_t;
+
 /**
  * flex_button_t
  * 
@@ -66,16 +662,29 @@ typedef enum
  * @member next
  *         Internal use.
  *         One-way linked list, pointing to the next button.
+ *         Not with FLEX_BTN_USING_ARRAY_STORAGE.
  * 
  * @member usr_button_read
  *         User function is used to read button vaule.
  * 
  * @member cb
  *         Button event callback function.
+ *         Not used with FLEX_BTN_USING_EVENT_QUEUE or FLEX_BTN_USING_EVENT_BATCH.
+ * 
+ * @member group
+ *         Only with FLEX_BTN_USING_GROUP_READ.
+ *         The group that reads this button, NULL to use 'usr_button_read'.
+ *         The group must be registered before the button.
+ * 
+ * @member group_bit
+ *         Only with FLEX_BTN_USING_GROUP_READ.
+ *         Bit index of this button in the value read by the group.
  * 
  * @member scan_cnt
  *         Internal use, user read-only.
  *         Number of scans, counted when the button is pressed, plus one per scan cycle.
+ *         Milliseconds since pressed with FLEX_BTN_USING_TIMESTAMP.
+ *         Not with FLEX_BTN_USING_ARRAY_STORAGE, see flex_button_snapshot.
  * 
  * @member click_cnt
  *         Internal use, user read-only.
@@ -86,8 +695,10 @@ typedef enum
  *         Need to use FLEX_MS_TO_SCAN_CNT to convert milliseconds into scan cnts.
  * 
  * @member debounce_tick
- *         Debounce. Not used yet.
- *         Need to use FLEX_MS_TO_SCAN_CNT to convert milliseconds into scan cnts.
+ *         Debounce, only with FLEX_BTN_USING_DEBOUNCE.
+ *         The button state changes after the new level is read in 'debounce_tick'
+ *         consecutive scans, 0 or 1 means no debounce.
+ *         Counts scans in all modes, up to (1 << FLEX_BTN_DEBOUNCE_CNT_BITS) - 1.
  * 
  * @member short_press_start_tick
  *         Short press start time. Requires user configuration.
@@ -100,6 +711,28 @@ typedef enum
  * @member long_hold_start_tick
  *         Long hold press start time. Requires user configuration.
  * 
+ * @member repeat_delay_tick, repeat_rate_tick
+ *         Only with FLEX_BTN_USING_REPEAT, 'repeat_rate_tick' 0 disables the repeat.
+ *         The first FLEX_BTN_PRESS_REPEAT is reported 'repeat_delay_tick' after
+ *         the button is pressed, then one every 'repeat_rate_tick' while it is held.
+ *         Released after a repeat or after 'short_press_start_tick', the button
+ *         reports one FLEX_BTN_PRESS_REPEAT_UP, no click and no *_UP event.
+ *         Need to use FLEX_MS_TO_SCAN_CNT to convert milliseconds into scan cnts.
+ * 
+ * @member repeat_accel_tick, repeat_min_tick
+ *         Only with FLEX_BTN_USING_REPEAT, optional acceleration.
+ *         Each repeat shortens the repeat interval by 'repeat_accel_tick',
+ *         down to 'repeat_min_tick'.
+ * 
+ * @member repeat_cnt
+ *         Internal use, user read-only. Only with FLEX_BTN_USING_REPEAT.
+ *         Number of repeats since the button was pressed, 1 at the first repeat,
+ *         also valid for FLEX_BTN_PRESS_REPEAT_UP.
+ * 
+ * @member repeat_wait
+ *         Internal use. Only with FLEX_BTN_USING_REPEAT.
+ *         Scan cnts from the last scan to the next repeat.
+ * 
  * @member id
  *         Button id. Requires user configuration.
  *         When multiple buttons use the same button callback function, 
@@ -113,20 +746,31 @@ typedef enum
  * @member event
  *         Internal use, users can call 'flex_button_event_read' to get current button event.
  *         Used to record the current button event.
+ *         Only updated before the callback with FLEX_BTN_USING_ARRAY_STORAGE.
  * 
  * @member status
  *         Internal use, user unavailable.
  *         Used to record the current state of buttons.
+ *         Not with FLEX_BTN_USING_ARRAY_STORAGE.
  * 
 */
 typedef struct flex_button
 {
+#ifndef FLEX_BTN_USING_ARRAY_STORAGE
     struct flex_button* next;
+#endif
 
     uint8_t  (*usr_button_read)(void *);
     flex_button_response_callback  cb;
 
+#ifdef FLEX_BTN_USING_GROUP_READ
+    flex_button_group_t *group;
+    uint8_t group_bit;
+#endif
+
+#ifndef FLEX_BTN_USING_ARRAY_STORAGE
     uint16_t scan_cnt;
+#endif
     uint16_t click_cnt;
     uint16_t max_multiple_clicks_interval;
 
@@ -135,19 +779,394 @@ typedef struct flex_button
     uint16_t long_press_start_tick;
     uint16_t long_hold_start_tick;
 
+#ifdef FLEX_BTN_USING_REPEAT
+    uint16_t repeat_delay_tick;
+    uint16_t repeat_rate_tick;
+    uint16_t repeat_accel_tick;
+    uint16_t repeat_min_tick;
+    uint16_t repeat_cnt;
+    uint16_t repeat_wait;
+#endif
+
     uint8_t id;
     uint8_t pressed_logic_level : 1;
     uint8_t event               : 4;
+#ifndef FLEX_BTN_USING_ARRAY_STORAGE
     uint8_t status              : 3;
+#endif
 } flex_button_t;
 
+/**
+ * flex_button_ctx_t
+ * 
+ * @brief Button context, holds a set of buttons and the state of their scan.
+ *        Each context is scanned independently, e.g. one context per scan thread.
+ *        All members are internal use.
+ *        The API without 'ctx' works on a default context.
+ * 
+ * @member btn_head
+ *         One-way linked list of the registered buttons, last registered first.
+ * 
+ * @member btn_table
+ *         Only with FLEX_BTN_USING_BTN_TABLE. Button of each bit of 'status_reg'.
+ * 
+ * @member slot_num
+ *         Only with FLEX_BTN_USING_UNREGISTER.
+ *         The bit indexes in use, up to the highest registered button.
+ * 
+ * @member btn_array, array_num
+ *         Only with FLEX_BTN_USING_ARRAY_STORAGE, replaces 'btn_head' and 'btn_table'.
+ *         The button array, button i is at bit i of 'status_reg'.
+ * 
+ * @member btn_status, btn_event, btn_scan_cnt, btn_click_cnt
+ *         Only with FLEX_BTN_USING_ARRAY_STORAGE.
+ *         The scan state of button i, used instead of the members of the button.
+ *         'event' and 'click_cnt' of the button are updated when an event is reported.
+ * 
+ * @member logic_level
+ *         The logic level of the button pressed, each bit represents a button.
+ *         First registered button, the logic level of the button pressed is 
+ *         at the low bit of logic_level.
+ * 
+ * @member status_reg
+ *         The status register of all button, each bit records the pressing state of a button.
+ *         First registered button, the pressing state of the button is 
+ *         at the low bit of status_reg.
+ * 
+ * @member active_reg
+ *         Each bit records a button that is in the middle of a gesture,
+ *         or still has an event to be cleared in the next scan.
+ *         Buttons that are neither pressed nor active are skipped by the scan.
+ * 
+ * @member mask
+ *         Each bit records a registered button.
+ * 
+ * @member enable
+ *         Only with FLEX_BTN_USING_UNREGISTER.
+ *         Each bit records a registered and enabled button, the pressing state
+ *         is read for these buttons only.
+ * 
+ * @member button_cnt
+ *         Number of registered buttons.
+ * 
+ * @member debounce_cnt
+ *         Vertical debounce counters, bit k of the counter of each button is in
+ *         debounce_cnt[w][k]. Counts the consecutive scans that the raw state
+ *         differs from status_reg.
+ * 
+ * @member debounce_tick
+ *         debounce_tick of each button, in the same layout as debounce_cnt.
+ * 
+ * @member last_ts
+ *         The time of the last processed scan, in milliseconds.
+ * 
+ * @member event_queue
+ *         Single-producer single-consumer event ring buffer.
+ *         'head' is only written by the scan, 'tail' only by flex_button_event_pop.
+ * 
+ * @member scan_total
+ *         Total scan count, the timestamp of the queued events.
+ * 
+ * @member batch_handler, batch_arg
+ *         Receives the events of each scan, see flex_button_ctx_batch_handler.
+ * 
+ * @member batch, batch_num
+ *         The events collected in the current scan, in an array on the stack
+ *         of the scan, NULL between the scans.
+ * 
+ * @member edge_queue
+ *         The level changes reported by flex_button_notify_edge, in order,
+ *         not handled by the tickless scan yet.
+ * 
+ * @member edge_level, edge_ts, edge_overflow
+ *         The last reported level of each button, and the time of the last
+ *         level change that did not fit in 'edge_queue'.
+ * 
+ * @member raw_reg, sample_ts, sample_pending
+ *         The level of each button after the handled level changes, and the
+ *         time of the scan that samples them when not processed yet.
+ * 
+ * @member active_cnt
+ *         Activated button count of the last tickless scan.
+ * 
+ * @member trace_hook, trace_arg
+ *         Receives the pressing state of each scan, see flex_button_ctx_trace_hook.
+ * 
+ * @member rules, rule_first
+ *         The rule table, and the first rule of each stage, rule_first[stage + 1]
+ *         is the end of the stage.
+ * 
+ * @member combo_head
+ *         One-way linked list of the registered combinations.
+ * 
+ * @member combo_prev, combo_suppress
+ *         'status_reg' of the last scan, and the buttons whose events are not
+ *         reported because they are used by a reported combination.
+ * 
+ * @member combo_hold, combo_held
+ *         The buttons of a last step waiting for 'hold_tick', and the events
+ *         held for each of them, bit e is the flex_button_event_t e.
+ * 
+ * @member encoder_head
+ *         One-way linked list of the registered encoders.
+ * 
+ * @member snapshot_seq
+ *         Odd while the scan state is being changed, incremented before and
+ *         after each change, see flex_button_ctx_snapshot.
+ * 
+ * @member snapshot_button
+ *         Copy of the scan state of each button, kept by the scan, so the
+ *         snapshot does not follow the button pointers. Not with
+ *         FLEX_BTN_USING_ARRAY_STORAGE, the state is in the context tables.
+ * 
+ * @member stats, scan_cycles_sum, scan_start, cb_start
+ *         Statistics of the scans, and the start cycles of the current scan and callback.
+ * 
+ * @member stats_raw, stats_changed
+ *         The last sampled levels, and the levels changed since the last process.
+ * 
+ * @member stats_clock, stats_edge
+ *         The processed scan cycles, and the cycle at the last level change of
+ *         each button, for the latency of the events.
+ * 
+*/
+typedef struct flex_button_ctx
+{
+#ifdef FLEX_BTN_USING_ARRAY_STORAGE
+    flex_button_t* btn_array;
+    btn_index_t array_num;
+
+    uint8_t  btn_status[FLEX_BTN_MAX_NUM];
+    uint8_t  btn_event[FLEX_BTN_MAX_NUM];
+    uint16_t btn_scan_cnt[FLEX_BTN_MAX_NUM];
+    uint16_t btn_click_cnt[FLEX_BTN_MAX_NUM];
+#else
+    flex_button_t* btn_head;
+#ifdef FLEX_BTN_USING_BTN_TABLE
+    flex_button_t* btn_table[FLEX_BTN_MAX_NUM];
+#endif
+#ifdef FLEX_BTN_USING_UNREGISTER
+    btn_index_t slot_num;
+#endif
+#endif
+#ifdef FLEX_BTN_USING_GROUP_READ
+    flex_button_group_t* group_head;
+#endif
+
+    btn_type_t logic_level[FLEX_BTN_STATUS_WORDS];
+    btn_type_t status_reg[FLEX_BTN_STATUS_WORDS];
+    btn_type_t active_reg[FLEX_BTN_STATUS_WORDS];
+    btn_type_t mask[FLEX_BTN_STATUS_WORDS];
+#ifdef FLEX_BTN_USING_UNREGISTER
+    btn_type_t enable[FLEX_BTN_STATUS_WORDS];
+#endif
+
+    btn_index_t button_cnt;
+
+#ifdef FLEX_BTN_USING_DEBOUNCE
+    btn_type_t debounce_cnt[FLEX_BTN_STATUS_WORDS][FLEX_BTN_DEBOUNCE_CNT_BITS];
+    btn_type_t debounce_tick[FLEX_BTN_STATUS_WORDS][FLEX_BTN_DEBOUNCE_CNT_BITS];
+#endif
+
+#if defined(FLEX_BTN_USING_TIMESTAMP) || defined(FLEX_BTN_USING_TICKLESS)
+    uint32_t last_ts;
+#endif
+
+#ifdef FLEX_BTN_USING_EVENT_QUEUE
+    struct
+    {
+        flex_button_event_record_t record[FLEX_BTN_EVENT_QUEUE_SIZE];
+        volatile uint16_t head;
+        volatile uint16_t tail;
+        volatile uint32_t overflow;
+    } event_queue;
+    uint32_t scan_total;
+#endif
+
+#ifdef FLEX_BTN_USING_EVENT_BATCH
+    flex_button_batch_handler_t batch_handler;
+    void *batch_arg;
+    flex_button_batch_event_t *batch;
+    uint16_t batch_num;
+#endif
+
+#ifdef FLEX_BTN_USING_TICKLESS
+    struct
+    {
+        struct
+        {
+            uint32_t timestamp;
+            btn_index_t index;
+            uint8_t level;
+        } record[FLEX_BTN_EDGE_QUEUE_SIZE];
+        volatile uint16_t head;
+        volatile uint16_t tail;
+    } edge_queue;
+    volatile btn_type_t edge_level[FLEX_BTN_STATUS_WORDS];
+    volatile uint32_t edge_ts;
+    volatile uint8_t edge_overflow;
+    btn_type_t raw_reg[FLEX_BTN_STATUS_WORDS];
+    uint32_t sample_ts;
+    uint8_t sample_pending;
+    uint8_t active_cnt;
+#endif
+
+#ifdef FLEX_BTN_USING_TRACE
+    flex_button_trace_hook_t trace_hook;
+    void *trace_arg;
+#endif
+
+#ifdef FLEX_BTN_USING_RULE_TABLE
+    const flex_button_rule_t *rules;
+    uint8_t rule_first[FLEX_BTN_RULE_STAGE_NUM + 1];
+#endif
+
+#ifdef FLEX_BTN_USING_COMBO
+    flex_button_combo_t* combo_head;
+    btn_type_t combo_prev[FLEX_BTN_STATUS_WORDS];
+    btn_type_t combo_suppress[FLEX_BTN_STATUS_WORDS];
+    btn_type_t combo_hold[FLEX_BTN_STATUS_WORDS];
+    uint16_t combo_held[FLEX_BTN_MAX_NUM];
+#endif
+
+#ifdef FLEX_BTN_USING_ENCODER
+    flex_button_encoder_t* encoder_head;
+#endif
+
+#ifdef FLEX_BTN_USING_SNAPSHOT
+    volatile uint32_t snapshot_seq;
+#ifndef FLEX_BTN_USING_ARRAY_STORAGE
+    flex_button_snapshot_button_t snapshot_button[FLEX_BTN_MAX_NUM];
+#endif
+#endif
+
+#ifdef FLEX_BTN_USING_STATS
+    flex_button_stats_t stats;
+    uint64_t scan_cycles_sum;
+    uint32_t scan_start;
+    uint32_t cb_start;
+    btn_type_t stats_raw[FLEX_BTN_STATUS_WORDS];
+    btn_type_t stats_changed[FLEX_BTN_STATUS_WORDS];
+    uint32_t stats_clock;
+    uint32_t stats_edge[FLEX_BTN_MAX_NUM];
+#endif
+} flex_button_ctx_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+void flex_button_ctx_init(flex_button_ctx_t *ctx);
+#ifdef FLEX_BTN_USING_ARRAY_STORAGE
+int32_t flex_button_ctx_array_init(flex_button_ctx_t *ctx, flex_button_t *buttons, uint16_t num);
+#endif
+int32_t flex_button_ctx_register(flex_button_ctx_t *ctx, flex_button_t *button);
+#ifdef FLEX_BTN_USING_UNREGISTER
+int32_t flex_button_ctx_unregister(flex_button_ctx_t *ctx, flex_button_t *button);
+int32_t flex_button_ctx_enable(flex_button_ctx_t *ctx, flex_button_t *button, uint8_t enable);
+void flex_button_ctx_enable_mask(flex_button_ctx_t *ctx, const btn_type_t *enable);
+#endif
+#ifdef FLEX_BTN_USING_GROUP_READ
+int32_t flex_button_ctx_group_register(flex_button_ctx_t *ctx, flex_button_group_t *group);
+#endif
+flex_button_event_t flex_button_ctx_event_read(flex_button_ctx_t *ctx, flex_button_t* button);
+#ifdef FLEX_BTN_USING_TIMESTAMP
+uint8_t flex_button_ctx_scan(flex_button_ctx_t *ctx, uint32_t now);
+#else
+uint8_t flex_button_ctx_scan(flex_button_ctx_t *ctx);
+#endif
+#ifdef FLEX_BTN_USING_EVENT_BATCH
+void flex_button_ctx_batch_handler(flex_button_ctx_t *ctx, flex_button_batch_handler_t handler, void *arg);
+#endif
+#ifdef FLEX_BTN_USING_TRACE
+void flex_button_ctx_trace_hook(flex_button_ctx_t *ctx, flex_button_trace_hook_t hook, void *arg);
+#ifdef FLEX_BTN_USING_TIMESTAMP
+uint8_t flex_button_ctx_replay(flex_button_ctx_t *ctx, const btn_type_t *pressed, uint32_t now);
+#else
+uint8_t flex_button_ctx_replay(flex_button_ctx_t *ctx, const btn_type_t *pressed);
+#endif
+#endif
+#ifdef FLEX_BTN_USING_RULE_TABLE
+int32_t flex_button_ctx_rules_set(flex_button_ctx_t *ctx, const flex_button_rule_t *rules, uint8_t num);
+#endif
+#ifdef FLEX_BTN_USING_COMBO
+int32_t flex_button_ctx_combo_register(flex_button_ctx_t *ctx, flex_button_combo_t *combo);
+#endif
+#ifdef FLEX_BTN_USING_ENCODER
+int32_t flex_button_ctx_encoder_register(flex_button_ctx_t *ctx, flex_button_encoder_t *encoder);
+#endif
+#ifdef FLEX_BTN_USING_STATS
+void flex_button_ctx_stats_get(flex_button_ctx_t *ctx, flex_button_stats_t *stats);
+void flex_button_ctx_stats_reset(flex_button_ctx_t *ctx);
+#endif
+#ifdef FLEX_BTN_USING_SNAPSHOT
+uint8_t flex_button_ctx_snapshot(flex_button_ctx_t *ctx, flex_button_snapshot_t *snapshot);
+#endif
+#ifdef FLEX_BTN_USING_EVENT_QUEUE
+uint8_t flex_button_ctx_event_pop(flex_button_ctx_t *ctx, flex_button_event_record_t *record);
+uint32_t flex_button_ctx_event_overflow(flex_button_ctx_t *ctx);
+#endif
+#ifdef FLEX_BTN_USING_TICKLESS
+int32_t flex_button_ctx_notify_edge(flex_button_ctx_t *ctx, uint8_t id, uint8_t level, uint32_t timestamp);
+uint8_t flex_button_ctx_tickless_scan(flex_button_ctx_t *ctx, uint32_t now);
+uint8_t flex_button_ctx_next_deadline(flex_button_ctx_t *ctx, uint32_t *timestamp);
+#endif
+
+flex_button_ctx_t *flex_button_default_ctx(void);
+#ifdef FLEX_BTN_USING_ARRAY_STORAGE
+int32_t flex_button_array_init(flex_button_t *buttons, uint16_t num);
+#endif
 int32_t flex_button_register(flex_button_t *button);
+#ifdef FLEX_BTN_USING_UNREGISTER
+int32_t flex_button_unregister(flex_button_t *button);
+int32_t flex_button_enable(flex_button_t *button, uint8_t enable);
+void flex_button_enable_mask(const btn_type_t *enable);
+#endif
+#ifdef FLEX_BTN_USING_GROUP_READ
+int32_t flex_button_group_register(flex_button_group_t *group);
+#endif
 flex_button_event_t flex_button_event_read(flex_button_t* button);
+#ifdef FLEX_BTN_USING_TIMESTAMP
+uint8_t flex_button_scan(uint32_t now);
+#else
 uint8_t flex_button_scan(void);
+#endif
+#ifdef FLEX_BTN_USING_EVENT_BATCH
+void flex_button_batch_handler(flex_button_batch_handler_t handler, void *arg);
+#endif
+#ifdef FLEX_BTN_USING_TRACE
+void flex_button_trace_hook(flex_button_trace_hook_t hook, void *arg);
+#ifdef FLEX_BTN_USING_TIMESTAMP
+uint8_t flex_button_replay(const btn_type_t *pressed, uint32_t now);
+#else
+uint8_t flex_button_replay(const btn_type_t *pressed);
+#endif
+#endif
+#ifdef FLEX_BTN_USING_RULE_TABLE
+int32_t flex_button_rules_set(const flex_button_rule_t *rules, uint8_t num);
+#endif
+#ifdef FLEX_BTN_USING_COMBO
+int32_t flex_button_combo_register(flex_button_combo_t *combo);
+#endif
+#ifdef FLEX_BTN_USING_ENCODER
+int32_t flex_button_encoder_register(flex_button_encoder_t *encoder);
+#endif
+#ifdef FLEX_BTN_USING_STATS
+void flex_button_stats_get(flex_button_stats_t *stats);
+void flex_button_stats_reset(void);
+#endif
+#ifdef FLEX_BTN_USING_SNAPSHOT
+uint8_t flex_button_snapshot(flex_button_snapshot_t *snapshot);
+#endif
+#ifdef FLEX_BTN_USING_EVENT_QUEUE
+uint8_t flex_button_event_pop(flex_button_event_record_t *record);
+uint32_t flex_button_event_overflow(void);
+#endif
+#ifdef FLEX_BTN_USING_TICKLESS
+int32_t flex_button_notify_edge(uint8_t id, uint8_t level, uint32_t timestamp);
+uint8_t flex_button_tickless_scan(uint32_t now);
+uint8_t flex_button_next_deadline(uint32_t *timestamp);
+#endif
 
 #ifdef __cplusplus
 }
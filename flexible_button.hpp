@@ -0,0 +1,352 @@
+/**
+ * @File:    flexible_button.hpp
+ * @Author:  agent
+ * @Date:    2026-10-17
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * message:
+ * Header-only C++ version of the button scan, for C++ firmware.
+ * The timing, the scan frequency, the read function and the event handler
+ * are given by a configuration type at compile time, so the compiler can
+ * inline the read and the handler and fold the timing constants.
+ * Reports the same events as flex_button_scan with the same settings,
+ * without the optional features of flexible_button.h.
+ *
+ * Usage:
+ *     struct KeyReader
+ *     {
+ *         static uint8_t read(uint8_t index) { return gpio_read(key_pin[index]); }
+ *     };
+ *
+ *     struct KeyHandler
+ *     {
+ *         static void on_event(uint8_t index, flex_button_event_t event, uint16_t click_cnt) { ... }
+ *     };
+ *
+ *     struct KeyConfig : FlexButtonConfig
+ *     {
+ *         typedef KeyReader Reader;
+ *         typedef KeyHandler Handler;
+ *         static const uint16_t long_press_start_ms = 2000;
+ *     };
+ *
+ *     static FlexButtons<4, KeyConfig> keys;
+ *     keys.scan(); // every 1000 / scan_freq_hz ms
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#ifndef __FLEXIBLE_BUTTON_HPP__
+#define __FLEXIBLE_BUTTON_HPP__
+
+#include "flexible_button.h"
+
+/**
+ * FlexButtonConfig
+ *
+ * @brief Default configuration of FlexButtons.
+ *        Derive from it, and hide the members to change in the derived type.
+ *
+ * @member Reader
+ *         Requires user configuration.
+ *         Type with 'static uint8_t read(uint8_t index)', returns the level of the button.
+ *
+ * @member Handler
+ *         Requires user configuration.
+ *         Type with 'static void on_event(uint8_t index, flex_button_event_t event, uint16_t click_cnt)',
+ *         called for each event, like the 'cb' of flex_button_t.
+ *
+ * @member scan_freq_hz
+ *         How often FlexButtons::scan is called, default FLEX_BTN_SCAN_FREQ_HZ.
+ *
+ * @member short_press_start_ms, long_press_start_ms, long_hold_start_ms
+ *         Same as 'short_press_start_tick' etc. of flex_button_t, in milliseconds.
+ *
+ * @member max_multiple_clicks_interval_ms
+ *         Same as 'max_multiple_clicks_interval' of flex_button_t, in milliseconds.
+ *
+ * @member pressed_logic_level
+ *         The logic level of each button pressed, bit i is button i.
+ *
+*/
+struct FlexButtonConfig
+{
+    static const uint16_t scan_freq_hz = FLEX_BTN_SCAN_FREQ_HZ;
+
+    static const uint16_t short_press_start_ms = 1500;
+    static const uint16_t long_press_start_ms = 3000;
+    static const uint16_t long_hold_start_ms = 4500;
+    static const uint16_t max_multiple_clicks_interval_ms = 300;
+
+    static const uint32_t pressed_logic_level = 0;
+};
+
+/**
+ * FlexButtons
+ *
+ * @brief N buttons scanned together, button i is bit i of the status register,
+ *        same as the i-th button registered with flex_button_register.
+ *
+ * @param N: number of buttons, 1 to 32
+ * @param Config: configuration type, see FlexButtonConfig
+*/
+template <uint8_t N, typename Config>
+class FlexButtons
+{
+public:
+    typedef typename Config::Reader Reader;
+    typedef typename Config::Handler Handler;
+
+    FlexButtons() : status_reg_(0), active_reg_(0)
+    {
+        for (uint8_t i = 0; i < N; i ++)
+        {
+            scan_cnt_[i] = 0;
+            click_cnt_[i] = 0;
+            event_[i] = FLEX_BTN_PRESS_NONE;
+            status_[i] = FLEX_BTN_STAGE_DEFAULT;
+        }
+    }
+
+    /**
+     * scan
+     *
+     * @brief Start key scan, same as flex_button_scan.
+     *
+     * @return Activated button count
+    */
+    uint8_t scan()
+    {
+        read();
+        return process();
+    }
+
+    /**
+     * event, click_cnt, scan_cnt
+     *
+     * @brief The current event, click count and scan count of button 'index'.
+    */
+    flex_button_event_t event(uint8_t index) const
+    {
+        return (flex_button_event_t)event_[index];
+    }
+
+    uint16_t click_cnt(uint8_t index) const
+    {
+        return click_cnt_[index];
+    }
+
+    uint16_t scan_cnt(uint8_t index) const
+    {
+        return scan_cnt_[index];
+    }
+
+    /**
+     * status
+     *
+     * @brief The pressing state of all buttons, bit i is button i.
+    */
+    uint32_t status() const
+    {
+        return status_reg_;
+    }
+
+private:
+    static const uint16_t ms_per_cnt = 1000 / Config::scan_freq_hz;
+    static const uint16_t short_press_start_tick = Config::short_press_start_ms / ms_per_cnt;
+    static const uint16_t long_press_start_tick = Config::long_press_start_ms / ms_per_cnt;
+    static const uint16_t long_hold_start_tick = Config::long_hold_start_ms / ms_per_cnt;
+    static const uint16_t max_multiple_clicks_interval = Config::max_multiple_clicks_interval_ms / ms_per_cnt;
+    static const uint32_t mask = (N >= 32) ? 0xFFFFFFFFUL : ((1UL << (N & 31)) - 1);
+
+    static_assert((N >= 1) && (N <= 32), "FlexButtons supports 1 to 32 buttons");
+    static_assert((Config::scan_freq_hz >= 1) && (Config::scan_freq_hz <= 1000), "scan_freq_hz must be 1 to 1000");
+
+    uint32_t status_reg_;
+    uint32_t active_reg_;
+
+    uint16_t scan_cnt_[N];
+    uint16_t click_cnt_[N];
+    uint8_t event_[N];
+    uint8_t status_[N];
+
+    static uint8_t msb(uint32_t x)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return (uint8_t)(31 - __builtin_clz(x));
+#else
+        uint8_t n = 0;
+
+        while (x >>= 1)
+        {
+            n ++;
+        }
+        return n;
+#endif
+    }
+
+    void report(uint8_t i, flex_button_event_t evt)
+    {
+        event_[i] = (uint8_t)evt;
+        Handler::on_event(i, evt, click_cnt_[i]);
+    }
+
+    void read()
+    {
+        uint32_t raw = 0;
+
+        for (uint8_t i = 0; i < N; i ++)
+        {
+            raw |= (uint32_t)(Reader::read(i) & 1) << i;
+        }
+
+        status_reg_ = ((~raw) ^ Config::pressed_logic_level) & mask;
+    }
+
+    /* Same state machine as flex_button_process */
+    uint8_t process()
+    {
+        uint8_t active_btn_cnt = 0;
+        uint32_t pending = status_reg_ | active_reg_;
+
+        active_reg_ = 0;
+
+        while (pending)
+        {
+            uint8_t i = msb(pending);
+            bool pressed = (status_reg_ >> i) & 1;
+
+            pending &= ~((uint32_t)1 << i);
+
+            if (status_[i] > FLEX_BTN_STAGE_DEFAULT)
+            {
+                uint32_t cnt = (uint32_t)scan_cnt_[i] + 1;
+
+                scan_cnt_[i] = (cnt >= 0xFFFF) ? long_hold_start_tick : (uint16_t)cnt;
+            }
+
+            switch (status_[i])
+            {
+            case FLEX_BTN_STAGE_DEFAULT:
+                if (pressed)
+                {
+                    scan_cnt_[i] = 0;
+                    click_cnt_[i] = 0;
+                    report(i, FLEX_BTN_PRESS_DOWN);
+                    status_[i] = FLEX_BTN_STAGE_DOWN;
+                }
+                else
+                {
+                    event_[i] = FLEX_BTN_PRESS_NONE;
+                }
+                break;
+
+            case FLEX_BTN_STAGE_DOWN:
+                if (pressed)
+                {
+                    if (click_cnt_[i] > 0)
+                    {
+                        if (scan_cnt_[i] > max_multiple_clicks_interval)
+                        {
+                            report(i, click_cnt_[i] < FLEX_BTN_PRESS_REPEAT_CLICK ?
+                                (flex_button_event_t)click_cnt_[i] : FLEX_BTN_PRESS_REPEAT_CLICK);
+                            status_[i] = FLEX_BTN_STAGE_DOWN;
+                            scan_cnt_[i] = 0;
+                            click_cnt_[i] = 0;
+                        }
+                    }
+                    else if (scan_cnt_[i] >= long_hold_start_tick)
+                    {
+                        if (event_[i] != FLEX_BTN_PRESS_LONG_HOLD)
+                        {
+                            report(i, FLEX_BTN_PRESS_LONG_HOLD);
+                        }
+                    }
+                    else if (scan_cnt_[i] >= long_press_start_tick)
+                    {
+                        if (event_[i] != FLEX_BTN_PRESS_LONG_START)
+                        {
+                            report(i, FLEX_BTN_PRESS_LONG_START);
+                        }
+                    }
+                    else if (scan_cnt_[i] >= short_press_start_tick)
+                    {
+                        if (event_[i] != FLEX_BTN_PRESS_SHORT_START)
+                        {
+                            report(i, FLEX_BTN_PRESS_SHORT_START);
+                        }
+                    }
+                }
+                else
+                {
+                    if (scan_cnt_[i] >= long_hold_start_tick)
+                    {
+                        report(i, FLEX_BTN_PRESS_LONG_HOLD_UP);
+                        status_[i] = FLEX_BTN_STAGE_DEFAULT;
+                    }
+                    else if (scan_cnt_[i] >= long_press_start_tick)
+                    {
+                        report(i, FLEX_BTN_PRESS_LONG_UP);
+                        status_[i] = FLEX_BTN_STAGE_DEFAULT;
+                    }
+                    else if (scan_cnt_[i] >= short_press_start_tick)
+                    {
+                        report(i, FLEX_BTN_PRESS_SHORT_UP);
+                        status_[i] = FLEX_BTN_STAGE_DEFAULT;
+                    }
+                    else
+                    {
+                        status_[i] = FLEX_BTN_STAGE_MULTIPLE_CLICK;
+                        click_cnt_[i] ++;
+                    }
+                }
+                break;
+
+            case FLEX_BTN_STAGE_MULTIPLE_CLICK:
+                if (pressed)
+                {
+                    status_[i] = FLEX_BTN_STAGE_DOWN;
+                    scan_cnt_[i] = 0;
+                }
+                else if (scan_cnt_[i] > max_multiple_clicks_interval)
+                {
+                    report(i, click_cnt_[i] < FLEX_BTN_PRESS_REPEAT_CLICK ?
+                        (flex_button_event_t)click_cnt_[i] : FLEX_BTN_PRESS_REPEAT_CLICK);
+                    status_[i] = FLEX_BTN_STAGE_DEFAULT;
+                }
+                break;
+            }
+
+            if (status_[i] > FLEX_BTN_STAGE_DEFAULT)
+            {
+                active_btn_cnt ++;
+                active_reg_ |= (uint32_t)1 << i;
+            }
+            else if (event_[i] != FLEX_BTN_PRESS_NONE)
+            {
+                active_reg_ |= (uint32_t)1 << i;
+            }
+        }
+
+        return active_btn_cnt;
+    }
+};
+
+#endif /* __FLEXIBLE_BUTTON_HPP__ */
@@ -0,0 +1,371 @@
+/**
+ * @File:    flexible_button_compact.c
+ * @Author:  agent
+ * @Date:    2026-10-17
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#include "flexible_button_compact.h"
+
+#ifndef NULL
+#define NULL 0
+#endif
+
+#define COMPACT_WORD(i) ((i) / FLEX_BTN_WORD_BITS)
+#define COMPACT_BIT(i)  ((btn_type_t)1 << ((i) % FLEX_BTN_WORD_BITS))
+
+/* Index of the highest set bit, x must not be 0 */
+#if defined(__GNUC__) || defined(__clang__)
+#define COMPACT_MSB(x) ((uint8_t)(sizeof(unsigned long) * 8 - 1 - __builtin_clzl(x)))
+#else
+#define COMPACT_MSB(x) flex_button_compact_msb(x)
+
+static uint8_t flex_button_compact_msb(btn_type_t x)
+{
+    uint8_t i = 0;
+
+    while (x >>= 1)
+    {
+        i ++;
+    }
+
+    return i;
+}
+#endif
+
+/* Full scan count of a key */
+#define COMPACT_SCAN_CNT(st) \
+    ((uint16_t)(((st)->scan_cnt << FLEX_BTN_COMPACT_PRESCALE_SHIFT) | (st)->sub_cnt))
+
+/* Report the click count as the event, same as flex_button_process */
+#define COMPACT_CLICK_EVENT(st)                                                \
+    ((st)->click_cnt < FLEX_BTN_PRESS_REPEAT_CLICK ?                           \
+        (flex_button_event_t)(st)->click_cnt : FLEX_BTN_PRESS_REPEAT_CLICK)
+
+static void flex_button_compact_cnt_set(flex_button_compact_state_t *st, uint16_t cnt)
+{
+    st->scan_cnt = (uint8_t)(cnt >> FLEX_BTN_COMPACT_PRESCALE_SHIFT);
+    st->sub_cnt = (uint8_t)(cnt & ((1 << FLEX_BTN_COMPACT_PRESCALE_SHIFT) - 1));
+}
+
+static void flex_button_compact_report(const flex_button_compact_config_t *config,
+    btn_index_t i, flex_button_event_t event)
+{
+    flex_button_compact_state_t *st = &config->state[i];
+    const flex_button_compact_handler_t *handler = &config->handlers[config->keys[i].handler];
+
+    st->event = event;
+    if (handler->cb)
+    {
+        handler->cb(i, event, st->click_cnt);
+    }
+}
+
+/**
+ * flex_button_compact_init
+ *
+ * @brief Check the description of the keys and clear their scan state.
+ *
+ * @param compact: compact key set
+ * @param config: description of the keys, must stay valid while scanning
+ * @return 0 on success, -1 when a key refers to a missing profile or handler,
+ *         or the timing of a profile is not below FLEX_BTN_COMPACT_CNT_MAX
+*/
+int32_t flex_button_compact_init(flex_button_compact_t *compact, const flex_button_compact_config_t *config)
+{
+    btn_index_t i;
+    uint8_t w;
+
+    if (!compact || !config || !config->keys || !config->profiles || !config->handlers ||
+        !config->state || (config->key_num == 0) || (config->key_num > FLEX_BTN_MAX_NUM))
+    {
+        return -1;
+    }
+
+    for (i = 0; i < config->profile_num; i ++)
+    {
+        const flex_button_compact_profile_t *profile = &config->profiles[i];
+
+        if ((profile->short_press_start_tick >= FLEX_BTN_COMPACT_CNT_MAX) ||
+            (profile->long_press_start_tick >= FLEX_BTN_COMPACT_CNT_MAX) ||
+            (profile->long_hold_start_tick >= FLEX_BTN_COMPACT_CNT_MAX) ||
+            (profile->max_multiple_clicks_interval >= FLEX_BTN_COMPACT_CNT_MAX))
+        {
+            return -1;
+        }
+    }
+
+    for (i = 0; i < config->key_num; i ++)
+    {
+        if ((config->keys[i].profile >= config->profile_num) ||
+            (config->keys[i].handler >= config->handler_num) ||
+            !config->handlers[config->keys[i].handler].usr_button_read)
+        {
+            return -1;
+        }
+
+        config->state[i].status = FLEX_BTN_STAGE_DEFAULT;
+        config->state[i].sub_cnt = 0;
+        config->state[i].event = FLEX_BTN_PRESS_NONE;
+        config->state[i].scan_cnt = 0;
+        config->state[i].click_cnt = 0;
+    }
+
+    compact->config = config;
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        compact->status_reg[w] = 0;
+        compact->active_reg[w] = 0;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Read the pressing state of all keys.
+ *
+ * @param compact: compact key set
+ * @return none
+*/
+static void flex_button_compact_read(flex_button_compact_t *compact)
+{
+    const flex_button_compact_config_t *config = compact->config;
+    btn_type_t status[FLEX_BTN_STATUS_WORDS] = { 0 };
+    btn_index_t i;
+    uint8_t w;
+
+    for (i = 0; i < config->key_num; i ++)
+    {
+        const flex_button_compact_key_t *key = &config->keys[i];
+        uint8_t level = config->handlers[key->handler].usr_button_read(i) & 1;
+
+        if (level == key->pressed_logic_level)
+        {
+            status[COMPACT_WORD(i)] |= COMPACT_BIT(i);
+        }
+    }
+
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        compact->status_reg[w] = status[w];
+    }
+}
+
+/**
+ * @brief Handle all key events in one scan cycle, same as flex_button_process.
+ *
+ * @param compact: compact key set
+ * @return Activated button count
+*/
+static uint8_t flex_button_compact_process(flex_button_compact_t *compact)
+{
+    const flex_button_compact_config_t *config = compact->config;
+    btn_index_t active_btn_cnt = 0;
+    btn_index_t i;
+    int16_t w;
+
+    for (w = FLEX_BTN_STATUS_WORDS - 1; w >= 0; w --)
+    {
+        btn_type_t pending = compact->status_reg[w] | compact->active_reg[w];
+
+        if (pending == 0)
+        {
+            continue; /* all keys of this word idle, nothing changed */
+        }
+
+        compact->active_reg[w] = 0;
+
+        /* Visit the pressed or active keys only, last key first */
+        while (pending)
+        {
+            flex_button_compact_state_t *st;
+            const flex_button_compact_profile_t *profile;
+            uint8_t pressed;
+
+            i = COMPACT_MSB(pending);
+            pending &= ~((btn_type_t)1 << i);
+            i += w * FLEX_BTN_WORD_BITS;
+
+            st = &config->state[i];
+            profile = &config->profiles[config->keys[i].profile];
+            pressed = (compact->status_reg[w] & COMPACT_BIT(i)) ? 1 : 0;
+
+            if (st->status > FLEX_BTN_STAGE_DEFAULT)
+            {
+                uint16_t scan_cnt = COMPACT_SCAN_CNT(st) + 1;
+
+                if (scan_cnt >= FLEX_BTN_COMPACT_CNT_MAX)
+                {
+                    scan_cnt = profile->long_hold_start_tick;
+                }
+                flex_button_compact_cnt_set(st, scan_cnt);
+            }
+
+            switch (st->status)
+            {
+            case FLEX_BTN_STAGE_DEFAULT: /* stage: default(button up) */
+                if (pressed)
+                {
+                    flex_button_compact_cnt_set(st, 0);
+                    st->click_cnt = 0;
+
+                    flex_button_compact_report(config, i, FLEX_BTN_PRESS_DOWN);
+
+                    /* swtich to button down stage */
+                    st->status = FLEX_BTN_STAGE_DOWN;
+                }
+                else
+                {
+                    st->event = FLEX_BTN_PRESS_NONE;
+                }
+                break;
+
+            case FLEX_BTN_STAGE_DOWN: /* stage: button down */
+                if (pressed)
+                {
+                    if (st->click_cnt > 0) /* multiple click */
+                    {
+                        if (COMPACT_SCAN_CNT(st) > profile->max_multiple_clicks_interval)
+                        {
+                            flex_button_compact_report(config, i, COMPACT_CLICK_EVENT(st));
+
+                            /* swtich to button down stage */
+                            st->status = FLEX_BTN_STAGE_DOWN;
+                            flex_button_compact_cnt_set(st, 0);
+                            st->click_cnt = 0;
+                        }
+                    }
+                    else if (COMPACT_SCAN_CNT(st) >= profile->long_hold_start_tick)
+                    {
+                        if (st->event != FLEX_BTN_PRESS_LONG_HOLD)
+                        {
+                            flex_button_compact_report(config, i, FLEX_BTN_PRESS_LONG_HOLD);
+                        }
+                    }
+                    else if (COMPACT_SCAN_CNT(st) >= profile->long_press_start_tick)
+                    {
+                        if (st->event != FLEX_BTN_PRESS_LONG_START)
+                        {
+                            flex_button_compact_report(config, i, FLEX_BTN_PRESS_LONG_START);
+                        }
+                    }
+                    else if (COMPACT_SCAN_CNT(st) >= profile->short_press_start_tick)
+                    {
+                        if (st->event != FLEX_BTN_PRESS_SHORT_START)
+                        {
+                            flex_button_compact_report(config, i, FLEX_BTN_PRESS_SHORT_START);
+                        }
+                    }
+                }
+                else /* button up */
+                {
+                    if (COMPACT_SCAN_CNT(st) >= profile->long_hold_start_tick)
+                    {
+                        flex_button_compact_report(config, i, FLEX_BTN_PRESS_LONG_HOLD_UP);
+                        st->status = FLEX_BTN_STAGE_DEFAULT;
+                    }
+                    else if (COMPACT_SCAN_CNT(st) >= profile->long_press_start_tick)
+                    {
+                        flex_button_compact_report(config, i, FLEX_BTN_PRESS_LONG_UP);
+                        st->status = FLEX_BTN_STAGE_DEFAULT;
+                    }
+                    else if (COMPACT_SCAN_CNT(st) >= profile->short_press_start_tick)
+                    {
+                        flex_button_compact_report(config, i, FLEX_BTN_PRESS_SHORT_UP);
+                        st->status = FLEX_BTN_STAGE_DEFAULT;
+                    }
+                    else
+                    {
+                        /* swtich to multiple click stage */
+                        st->status = FLEX_BTN_STAGE_MULTIPLE_CLICK;
+                        if (st->click_cnt < 0xFF)
+                        {
+                            st->click_cnt ++;
+                        }
+                    }
+                }
+                break;
+
+            case FLEX_BTN_STAGE_MULTIPLE_CLICK: /* stage: multiple click */
+                if (pressed)
+                {
+                    /* swtich to button down stage */
+                    st->status = FLEX_BTN_STAGE_DOWN;
+                    flex_button_compact_cnt_set(st, 0);
+                }
+                else if (COMPACT_SCAN_CNT(st) > profile->max_multiple_clicks_interval)
+                {
+                    flex_button_compact_report(config, i, COMPACT_CLICK_EVENT(st));
+
+                    /* swtich to default stage */
+                    st->status = FLEX_BTN_STAGE_DEFAULT;
+                }
+                break;
+            }
+
+            if (st->status > FLEX_BTN_STAGE_DEFAULT)
+            {
+                active_btn_cnt ++;
+                compact->active_reg[w] |= COMPACT_BIT(i);
+            }
+            else if (st->event != FLEX_BTN_PRESS_NONE)
+            {
+                compact->active_reg[w] |= COMPACT_BIT(i);
+            }
+        }
+    }
+
+#if FLEX_BTN_STATUS_WORDS < 8
+    return active_btn_cnt;
+#else
+    return active_btn_cnt > 0xFF ? 0xFF : (uint8_t)active_btn_cnt;
+#endif
+}
+
+/**
+ * flex_button_compact_scan
+ *
+ * @brief Start key scan of a compact key set.
+ *        Need to be called cyclically within the specified period.
+ *
+ * @param compact: compact key set
+ * @return Activated button count
+*/
+uint8_t flex_button_compact_scan(flex_button_compact_t *compact)
+{
+    flex_button_compact_read(compact);
+    return flex_button_compact_process(compact);
+}
+
+/**
+ * flex_button_compact_event_read
+ *
+ * @brief Get the button event of the specified key.
+ *
+ * @param compact: compact key set
+ * @param index: key index
+ * @return button event
+*/
+flex_button_event_t flex_button_compact_event_read(flex_button_compact_t *compact, btn_index_t index)
+{
+    return (flex_button_event_t)compact->config->state[index].event;
+}
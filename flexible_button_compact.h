@@ -0,0 +1,195 @@
+/**
+ * @File:    flexible_button_compact.h
+ * @Author:  agent
+ * @Date:    2026-10-17
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * message:
+ * Compact button scan for MCU with little RAM. The keys are described by
+ * constant tables that stay in flash: each key refers to a shared timing
+ * profile and a shared read/callback entry by a small index. Only 3 bytes
+ * of scan state per key and 2 bits of the status registers are kept in RAM.
+ * Reports the same events as flex_button_scan with the same timing,
+ * without the optional features of flexible_button.h.
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#ifndef __FLEXIBLE_BUTTON_COMPACT_H__
+#define __FLEXIBLE_BUTTON_COMPACT_H__
+
+#include "flexible_button.h"
+
+/* The profiles are in scan counts, and MAX_MULTIPLE_CLICKS_INTERVAL must be too */
+#ifdef FLEX_BTN_USING_TIMESTAMP
+#error "flexible_button_compact counts scans, it can not be used with FLEX_BTN_USING_TIMESTAMP"
+#endif
+
+/**
+ * FLEX_BTN_COMPACT_PRESCALE_SHIFT
+ *
+ * The 8-bit scan count of each key counts 2^FLEX_BTN_COMPACT_PRESCALE_SHIFT
+ * scans, the scans in between are counted in the spare bits of the state byte,
+ * so the timing keeps the resolution of one scan. 0 to 2, default 2.
+*/
+#ifndef FLEX_BTN_COMPACT_PRESCALE_SHIFT
+#define FLEX_BTN_COMPACT_PRESCALE_SHIFT 2
+#endif
+
+#if (FLEX_BTN_COMPACT_PRESCALE_SHIFT < 0) || (FLEX_BTN_COMPACT_PRESCALE_SHIFT > 2)
+#error "FLEX_BTN_COMPACT_PRESCALE_SHIFT must be 0 to 2"
+#endif
+
+/* The scan count of a key saturates here, all timing must be below it */
+#define FLEX_BTN_COMPACT_CNT_MAX ((0x100 << FLEX_BTN_COMPACT_PRESCALE_SHIFT) - 1)
+
+/**
+ * flex_button_compact_profile_t
+ *
+ * @brief Timing shared by the keys that refer to it, in scan counts,
+ *        same as the members of flex_button_t. All below FLEX_BTN_COMPACT_CNT_MAX.
+ *        flex_button_register always uses MAX_MULTIPLE_CLICKS_INTERVAL, set
+ *        'max_multiple_clicks_interval' to it for the same events.
+*/
+typedef struct flex_button_compact_profile
+{
+    uint16_t short_press_start_tick;
+    uint16_t long_press_start_tick;
+    uint16_t long_hold_start_tick;
+    uint16_t max_multiple_clicks_interval;
+} flex_button_compact_profile_t;
+
+/**
+ * flex_button_compact_handler_t
+ *
+ * @brief Read and callback functions shared by the keys that refer to it.
+ *
+ * @member usr_button_read
+ *         User function is used to read the level of key 'index'.
+ *
+ * @member cb
+ *         Button event callback function, NULL for none.
+ *         'click_cnt' is the click count of the key, up to 255.
+*/
+typedef struct flex_button_compact_handler
+{
+    uint8_t (*usr_button_read)(btn_index_t index);
+    void (*cb)(btn_index_t index, flex_button_event_t event, uint16_t click_cnt);
+} flex_button_compact_handler_t;
+
+/**
+ * flex_button_compact_key_t
+ *
+ * @brief Description of a key, one byte, kept in a constant table.
+ *
+ * @member profile
+ *         Index of the timing profile of the key.
+ *
+ * @member handler
+ *         Index of the read and callback functions of the key.
+ *
+ * @member pressed_logic_level
+ *         The logic level of the key pressed.
+*/
+typedef struct flex_button_compact_key
+{
+    uint8_t profile             : 4;
+    uint8_t handler             : 3;
+    uint8_t pressed_logic_level : 1;
+} flex_button_compact_key_t;
+
+/**
+ * flex_button_compact_state_t
+ *
+ * @brief Internal use, the scan state of a key, 3 bytes.
+ *        The scan count is scan_cnt << FLEX_BTN_COMPACT_PRESCALE_SHIFT | sub_cnt.
+*/
+typedef struct flex_button_compact_state
+{
+    uint8_t status  : 2;
+    uint8_t sub_cnt : 2;
+    uint8_t event   : 4;
+    uint8_t scan_cnt;
+    uint8_t click_cnt;
+} flex_button_compact_state_t;
+
+/* 'event' has 4 bits, FLEX_BTN_PRESS_NONE must fit, the array size is -1 otherwise */
+typedef char flex_button_compact_event_check_t[(FLEX_BTN_PRESS_NONE < 16) ? 1 : -1];
+
+/**
+ * flex_button_compact_config_t
+ *
+ * @brief Constant description of a set of keys, can be kept in flash.
+ *
+ * @member keys
+ *         Description of each key, key i is at bit i of 'status_reg'.
+ *
+ * @member profiles, profile_num
+ *         Timing profiles, up to 16.
+ *
+ * @member handlers, handler_num
+ *         Read and callback functions, up to 8.
+ *
+ * @member state
+ *         RAM array of 'key_num' states, the only RAM used per key.
+ *
+ * @member key_num
+ *         Number of keys, up to FLEX_BTN_MAX_NUM.
+*/
+typedef struct flex_button_compact_config
+{
+    const flex_button_compact_key_t *keys;
+    const flex_button_compact_profile_t *profiles;
+    const flex_button_compact_handler_t *handlers;
+    flex_button_compact_state_t *state;
+
+    btn_index_t key_num;
+    uint8_t profile_num;
+    uint8_t handler_num;
+} flex_button_compact_config_t;
+
+/**
+ * flex_button_compact_t
+ *
+ * @brief Compact key set, all members are internal use.
+ *
+ * @member status_reg, active_reg
+ *         Same as the members of flex_button_ctx_t.
+*/
+typedef struct flex_button_compact
+{
+    const flex_button_compact_config_t *config;
+
+    btn_type_t status_reg[FLEX_BTN_STATUS_WORDS];
+    btn_type_t active_reg[FLEX_BTN_STATUS_WORDS];
+} flex_button_compact_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int32_t flex_button_compact_init(flex_button_compact_t *compact, const flex_button_compact_config_t *config);
+uint8_t flex_button_compact_scan(flex_button_compact_t *compact);
+flex_button_event_t flex_button_compact_event_read(flex_button_compact_t *compact, btn_index_t index);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __FLEXIBLE_BUTTON_COMPACT_H__ */
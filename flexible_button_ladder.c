@@ -0,0 +1,149 @@
+/**
+ * @File:    flexible_button_ladder.c
+ * @Author:  agent
+ * @Date:    2026-10-17
+ * 
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#include "flexible_button_ladder.h"
+
+#ifndef NULL
+#define NULL 0
+#endif
+
+/**
+ * @brief Map an ADC sample to a key.
+ *        The current key is kept while the sample stays within its range
+ *        widened by 'hysteresis' on both sides.
+ * 
+ * @param ladder: ladder structure instance
+ * @param sample: ADC sample
+ * @return The pressed key, 'key_num' when no key is pressed
+*/
+static uint8_t flex_button_ladder_key(flex_button_ladder_t *ladder, uint16_t sample)
+{
+    uint8_t k = ladder->key;
+    uint32_t low = (k > 0) ? ladder->thresholds[k - 1] : 0;
+    uint32_t high = (k < ladder->key_num) ? ladder->thresholds[k] : 0x10000UL;
+
+    if ((sample + (uint32_t)ladder->hysteresis >= low) &&
+        (sample < high + ladder->hysteresis))
+    {
+        return k;
+    }
+
+    for (k = 0; k < ladder->key_num; k ++)
+    {
+        if (sample < ladder->thresholds[k])
+        {
+            break;
+        }
+    }
+
+    return k;
+}
+
+/**
+ * @brief Group read function of the ladder, one ADC sample per scan cycle.
+ * 
+ * @param arg: ladder structure instance
+ * @return The pressed key of the ladder, bit k is key k
+*/
+static btn_type_t flex_button_ladder_group_read(void *arg)
+{
+    flex_button_ladder_t *ladder = (flex_button_ladder_t *)arg;
+
+    ladder->sample = ladder->usr_adc_read();
+    ladder->key = flex_button_ladder_key(ladder, ladder->sample);
+
+    if (ladder->key >= ladder->key_num)
+    {
+        return 0;
+    }
+
+    return (btn_type_t)1 << ladder->key;
+}
+
+/**
+ * @brief Register all keys of a resistor ladder
+ * 
+ * @param ctx: button context
+ * @param ladder: ladder structure instance
+ * @param buttons: key_num buttons, key k is buttons[k].
+ *        id, cb and press ticks need to be initialized by user,
+ *        'usr_button_read', 'group' and 'pressed_logic_level' are set here.
+ *        With FLEX_BTN_USING_ARRAY_STORAGE, they must be in the button array of the context.
+ * @return Number of keys that have been registered, or -1 when error
+*/
+int32_t flex_button_ctx_ladder_register(flex_button_ctx_t *ctx,
+    flex_button_ladder_t *ladder, flex_button_t *buttons)
+{
+    uint8_t k;
+    int32_t ret = -1;
+
+    if (!ladder || !buttons || !ladder->usr_adc_read || !ladder->thresholds ||
+        (ladder->key_num == 0) || (ladder->key_num > FLEX_BTN_WORD_BITS))
+    {
+        return -1;
+    }
+
+    for (k = 1; k < ladder->key_num; k ++)
+    {
+        if (ladder->thresholds[k] <= ladder->thresholds[k - 1])
+        {
+            return -1;  /* not in ascending order. */
+        }
+    }
+
+    ladder->sample = 0;
+    ladder->key = ladder->key_num;
+    ladder->group.usr_group_read = flex_button_ladder_group_read;
+
+    if (flex_button_ctx_group_register(ctx, &ladder->group) < 0)
+    {
+        return -1;
+    }
+
+    for (k = 0; k < ladder->key_num; k ++)
+    {
+        buttons[k].usr_button_read = NULL;
+        buttons[k].group = &ladder->group;
+        buttons[k].group_bit = k;
+        buttons[k].pressed_logic_level = 1; /* group value is 1 when pressed */
+
+        ret = flex_button_ctx_register(ctx, &buttons[k]);
+        if (ret < 0)
+        {
+            return -1;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Register all keys of a resistor ladder to the default context
+*/
+int32_t flex_button_ladder_register(flex_button_ladder_t *ladder, flex_button_t *buttons)
+{
+    return flex_button_ctx_ladder_register(flex_button_default_ctx(), ladder, buttons);
+}
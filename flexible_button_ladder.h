@@ -0,0 +1,101 @@
+/**
+ * @File:    flexible_button_ladder.h
+ * @Author:  agent
+ * @Date:    2026-10-17
+ * 
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * message:
+ * Resistor ladder backend, several keys on one ADC input. The ADC is
+ * sampled once per scan cycle and the sample is mapped to a key through a
+ * threshold table, the keys are read into flex_button through a button group.
+ * Requires FLEX_BTN_USING_GROUP_READ.
+ * 
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#ifndef __FLEXIBLE_BUTTON_LADDER_H__
+#define __FLEXIBLE_BUTTON_LADDER_H__
+
+#include "flexible_button.h"
+
+#ifndef FLEX_BTN_USING_GROUP_READ
+#error "flexible_button_ladder requires FLEX_BTN_USING_GROUP_READ"
+#endif
+
+/**
+ * flex_button_ladder_t
+ * 
+ * @brief Resistor ladder data structure
+ *        Only one key of a ladder is reported at a time.
+ *        Below are members that need to user init before register.
+ * 
+ * @member group
+ *         Internal use.
+ *         Button group of the keys of the ladder.
+ * 
+ * @member usr_adc_read
+ *         User function is used to sample the ADC input of the ladder.
+ * 
+ * @member thresholds
+ *         Upper edge of the ADC range of each key, in ascending order.
+ *         Key k is pressed when the sample is from thresholds[k - 1] (0 for key 0)
+ *         to thresholds[k] - 1, no key is pressed from thresholds[key_num - 1] up.
+ * 
+ * @member key_num
+ *         Number of keys, up to FLEX_BTN_WORD_BITS.
+ * 
+ * @member hysteresis
+ *         The sample must leave the range of the current key by more than
+ *         'hysteresis' to change the key, so noise at an edge does not toggle it.
+ * 
+ * @member sample
+ *         Internal use, user read-only.
+ *         The last ADC sample.
+ * 
+ * @member key
+ *         Internal use, user read-only.
+ *         The pressed key, 'key_num' when no key is pressed.
+*/
+typedef struct flex_button_ladder
+{
+    flex_button_group_t group;
+
+    uint16_t (*usr_adc_read)(void);
+    const uint16_t *thresholds;
+
+    uint8_t key_num;
+    uint16_t hysteresis;
+
+    uint16_t sample;
+    uint8_t key;
+} flex_button_ladder_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int32_t flex_button_ctx_ladder_register(flex_button_ctx_t *ctx,
+    flex_button_ladder_t *ladder, flex_button_t *buttons);
+int32_t flex_button_ladder_register(flex_button_ladder_t *ladder, flex_button_t *buttons);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __FLEXIBLE_BUTTON_LADDER_H__ */
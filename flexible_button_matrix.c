@@ -0,0 +1,204 @@
+/**
+ * @File:    flexible_button_matrix.c
+ * @Author:  agent
+ * @Date:    2026-10-17
+ * 
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#include "flexible_button_matrix.h"
+
+#ifndef NULL
+#define NULL 0
+#endif
+
+/**
+ * @brief Scan the whole matrix and block ghost keys.
+ * 
+ *        Without diodes, when two rows share two pressed columns, the fourth
+ *        key of the rectangle reads as pressed even if it is not (ghosting).
+ *        The keys of such rectangles keep their previous state until the
+ *        ambiguity is resolved, so a ghost key is never reported.
+ * 
+ * @param matrix: matrix structure instance
+ * @return none
+*/
+static void flex_button_matrix_scan(flex_button_matrix_t *matrix)
+{
+    uint8_t r, k;
+    btn_type_t raw[FLEX_BTN_MATRIX_MAX_ROWS];
+    btn_type_t ghost[FLEX_BTN_MATRIX_MAX_ROWS];
+    btn_type_t col_mask = (matrix->cols >= FLEX_BTN_WORD_BITS) ?
+        ~(btn_type_t)0 : (((btn_type_t)1 << matrix->cols) - 1);
+    btn_type_t common;
+    uint8_t ghosted = 0;
+
+    for (r = 0; r < matrix->rows; r ++)
+    {
+        matrix->usr_row_drive(r, 1);
+        raw[r] = matrix->usr_col_read();
+        matrix->usr_row_drive(r, 0);
+
+        raw[r] = (matrix->pressed_logic_level ? raw[r] : ~raw[r]) & col_mask;
+        ghost[r] = 0;
+    }
+
+    for (r = 0; r < matrix->rows; r ++)
+    {
+        if ((raw[r] & (raw[r] - 1)) == 0)
+        {
+            continue; /* less than two keys in this row */
+        }
+
+        for (k = r + 1; k < matrix->rows; k ++)
+        {
+            common = raw[r] & raw[k];
+            if (common & (common - 1))
+            {
+                ghost[r] |= common;
+                ghost[k] |= common;
+                ghosted = 1;
+            }
+        }
+    }
+
+    for (r = 0; r < matrix->rows; r ++)
+    {
+        matrix->row_state[r] = (raw[r] & ~ghost[r]) | (matrix->row_state[r] & ghost[r]);
+    }
+
+    if (ghosted)
+    {
+        matrix->ghost_cnt ++;
+    }
+}
+
+/**
+ * @brief Group read function of the matrix rows.
+ *        The first group read in a scan cycle scans the whole matrix,
+ *        the other groups take their rows from that scan.
+ * 
+ * @param arg: matrix group structure instance
+ * @return Pressed keys of the rows of the group
+*/
+static btn_type_t flex_button_matrix_group_read(void *arg)
+{
+    flex_button_matrix_group_t *mgroup = (flex_button_matrix_group_t *)arg;
+    flex_button_matrix_t *matrix = mgroup->matrix;
+    uint8_t index = (uint8_t)(mgroup - matrix->groups);
+    uint8_t rows_per_group = FLEX_BTN_WORD_BITS / matrix->cols;
+    uint8_t r;
+    btn_type_t value = 0;
+
+    if (!(matrix->fresh & (1UL << index)))
+    {
+        flex_button_matrix_scan(matrix);
+        matrix->fresh = 0xFFFFFFFFUL;
+    }
+    matrix->fresh &= ~(1UL << index);
+
+    for (r = 0; (r < rows_per_group) && (mgroup->first_row + r < matrix->rows); r ++)
+    {
+        value |= matrix->row_state[mgroup->first_row + r] << (r * matrix->cols);
+    }
+
+    return value;
+}
+
+/**
+ * @brief Register all keys of a keyboard matrix
+ * 
+ * @param ctx: button context
+ * @param matrix: matrix structure instance
+ * @param buttons: rows * cols buttons, key (r, c) is buttons[r * cols + c].
+ *        id, cb and press ticks need to be initialized by user,
+ *        'usr_button_read', 'group' and 'pressed_logic_level' are set here.
+ *        With FLEX_BTN_USING_ARRAY_STORAGE, they must be in the button array of the context.
+ * @return Number of keys that have been registered, or -1 when error
+*/
+int32_t flex_button_ctx_matrix_register(flex_button_ctx_t *ctx,
+    flex_button_matrix_t *matrix, flex_button_t *buttons)
+{
+    uint8_t r, c;
+    uint8_t rows_per_group;
+    uint8_t group_cnt;
+    flex_button_t *button;
+    int32_t ret = -1;
+
+    if (!matrix || !buttons || !matrix->usr_row_drive || !matrix->usr_col_read ||
+        (matrix->rows == 0) || (matrix->rows > FLEX_BTN_MATRIX_MAX_ROWS) ||
+        (matrix->cols == 0) || (matrix->cols > FLEX_BTN_WORD_BITS))
+    {
+        return -1;
+    }
+
+    rows_per_group = FLEX_BTN_WORD_BITS / matrix->cols;
+    group_cnt = (matrix->rows + rows_per_group - 1) / rows_per_group;
+
+    matrix->ghost_cnt = 0;
+    matrix->fresh = 0;
+
+    for (r = 0; r < matrix->rows; r ++)
+    {
+        matrix->row_state[r] = 0;
+        matrix->usr_row_drive(r, 0);
+    }
+
+    for (r = 0; r < group_cnt; r ++)
+    {
+        matrix->groups[r].group.usr_group_read = flex_button_matrix_group_read;
+        matrix->groups[r].matrix = matrix;
+        matrix->groups[r].first_row = r * rows_per_group;
+
+        if (flex_button_ctx_group_register(ctx, &matrix->groups[r].group) < 0)
+        {
+            return -1;
+        }
+    }
+
+    for (r = 0; r < matrix->rows; r ++)
+    {
+        for (c = 0; c < matrix->cols; c ++)
+        {
+            button = &buttons[r * matrix->cols + c];
+            button->usr_button_read = NULL;
+            button->group = &matrix->groups[r / rows_per_group].group;
+            button->group_bit = (r % rows_per_group) * matrix->cols + c;
+            button->pressed_logic_level = 1; /* group value is 1 when pressed */
+
+            ret = flex_button_ctx_register(ctx, button);
+            if (ret < 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Register all keys of a keyboard matrix to the default context
+*/
+int32_t flex_button_matrix_register(flex_button_matrix_t *matrix, flex_button_t *buttons)
+{
+    return flex_button_ctx_matrix_register(flex_button_default_ctx(), matrix, buttons);
+}
@@ -0,0 +1,127 @@
+/**
+ * @File:    flexible_button_matrix.h
+ * @Author:  agent
+ * @Date:    2026-10-17
+ * 
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * message:
+ * Keyboard matrix backend, the whole matrix is scanned once per scan cycle
+ * and read into flex_button through button groups.
+ * Requires FLEX_BTN_USING_GROUP_READ.
+ * 
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#ifndef __FLEXIBLE_BUTTON_MATRIX_H__
+#define __FLEXIBLE_BUTTON_MATRIX_H__
+
+#include "flexible_button.h"
+
+#ifndef FLEX_BTN_USING_GROUP_READ
+#error "flexible_button_matrix requires FLEX_BTN_USING_GROUP_READ"
+#endif
+
+#ifndef FLEX_BTN_MATRIX_MAX_ROWS
+#define FLEX_BTN_MATRIX_MAX_ROWS 16
+#endif
+
+struct flex_button_matrix;
+
+/**
+ * flex_button_matrix_group_t
+ * 
+ * @brief Internal use.
+ *        Button group of some rows of the matrix.
+*/
+typedef struct flex_button_matrix_group
+{
+    flex_button_group_t group;
+
+    struct flex_button_matrix* matrix;
+    uint8_t first_row;
+} flex_button_matrix_group_t;
+
+/**
+ * flex_button_matrix_t
+ * 
+ * @brief Keyboard matrix data structure
+ *        Below are members that need to user init before register.
+ * 
+ * @member usr_row_drive
+ *         User function is used to drive a row line.
+ *         active 1: drive the row to the active level, 0: release the row.
+ * 
+ * @member usr_col_read
+ *         User function is used to read all column lines, bit c is column c.
+ * 
+ * @member rows
+ *         Number of rows, up to FLEX_BTN_MATRIX_MAX_ROWS.
+ * 
+ * @member cols
+ *         Number of columns, up to FLEX_BTN_WORD_BITS.
+ * 
+ * @member pressed_logic_level
+ *         The column level read when a key of the driven row is pressed.
+ * 
+ * @member ghost_cnt
+ *         Internal use, user read-only.
+ *         Number of scans that blocked ghost keys.
+ * 
+ * @member row_state
+ *         Internal use, user read-only.
+ *         Pressed keys of each row, bit c is column c.
+ * 
+ * @member fresh
+ *         Internal use.
+ *         Groups that have not read the last matrix scan yet.
+ * 
+ * @member groups
+ *         Internal use.
+ *         Button groups, each holds as many rows as fit in a btn_type_t.
+*/
+typedef struct flex_button_matrix
+{
+    void (*usr_row_drive)(uint8_t row, uint8_t active);
+    btn_type_t (*usr_col_read)(void);
+
+    uint8_t rows;
+    uint8_t cols;
+    uint8_t pressed_logic_level;
+
+    uint32_t ghost_cnt;
+
+    btn_type_t row_state[FLEX_BTN_MATRIX_MAX_ROWS];
+    uint32_t fresh;
+
+    flex_button_matrix_group_t groups[FLEX_BTN_MATRIX_MAX_ROWS];
+} flex_button_matrix_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int32_t flex_button_ctx_matrix_register(flex_button_ctx_t *ctx,
+    flex_button_matrix_t *matrix, flex_button_t *buttons);
+int32_t flex_button_matrix_register(flex_button_matrix_t *matrix, flex_button_t *buttons);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __FLEXIBLE_BUTTON_MATRIX_H__ */
@@ -0,0 +1,168 @@
+/**
+ * @File:    flexible_button_touch.c
+ * @Author:  agent
+ * @Date:    2026-10-17
+ * 
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#include "flexible_button_touch.h"
+
+#ifndef NULL
+#define NULL 0
+#endif
+
+/**
+ * flex_button_touch_filter
+ * 
+ * @brief Update the baselines with the raw counts of one scan,
+ *        and get the touched pads.
+ *        All channels are handled by one branch-free integer loop,
+ *        which the compiler can vectorize.
+ * 
+ * @param touch: touch structure instance
+ * @param counts: raw count of each channel, 'channel_num' counts
+ * @return The touched pads, bit c is channel c
+*/
+btn_type_t flex_button_touch_filter(flex_button_touch_t *touch, const uint16_t *counts)
+{
+    int32_t *baseline = touch->baseline;
+    uint8_t *touched = touch->touched;
+    uint16_t *on_cnt = touch->on_cnt;
+    const uint16_t *thresholds = touch->thresholds;
+    int32_t hysteresis = touch->hysteresis;
+    uint16_t max_on = touch->max_on_tick;
+    uint8_t num = touch->channel_num;
+    btn_type_t value = 0;
+    uint8_t c;
+
+    if (!touch->ready)
+    {
+        for (c = 0; c < num; c ++)
+        {
+            baseline[c] = (int32_t)counts[c] << FLEX_BTN_TOUCH_FILTER_SHIFT;
+            touched[c] = 0;
+            on_cnt[c] = 0;
+        }
+        touch->ready = 1;
+    }
+
+    for (c = 0; c < num; c ++)
+    {
+        int32_t delta = (int32_t)counts[c] - (baseline[c] >> FLEX_BTN_TOUCH_FILTER_SHIFT);
+        int32_t th = (int32_t)thresholds[c] - (touched[c] ? hysteresis : 0);
+        uint8_t on = delta >= th;
+        uint16_t cnt = on ? on_cnt[c] + 1 : 0;
+        uint8_t recal = (max_on > 0) && (cnt >= max_on);
+
+        /**
+         * baseline += count - baseline / 2^shift, held while touched,
+         * and set to the count when touched for longer than 'max_on_tick'.
+        */
+        baseline[c] = recal ? (int32_t)counts[c] << FLEX_BTN_TOUCH_FILTER_SHIFT :
+                              baseline[c] + (on ? 0 : delta);
+        touched[c] = on & !recal;
+        on_cnt[c] = recal ? 0 : cnt;
+    }
+
+    for (c = 0; c < num; c ++)
+    {
+        value |= (btn_type_t)touched[c] << c;
+    }
+
+    return value;
+}
+
+/**
+ * @brief Group read function of the touch pads, one count read per scan cycle.
+ * 
+ * @param arg: touch structure instance
+ * @return The touched pads, bit c is channel c
+*/
+static btn_type_t flex_button_touch_group_read(void *arg)
+{
+    flex_button_touch_t *touch = (flex_button_touch_t *)arg;
+
+    touch->usr_count_read(touch->counts, touch->channel_num);
+
+    return flex_button_touch_filter(touch, touch->counts);
+}
+
+/**
+ * @brief Register all pads of a capacitive touch group
+ * 
+ * @param ctx: button context
+ * @param touch: touch structure instance
+ * @param buttons: channel_num buttons, channel c is buttons[c].
+ *        id, cb and press ticks need to be initialized by user,
+ *        'usr_button_read', 'group' and 'pressed_logic_level' are set here.
+ *        With FLEX_BTN_USING_ARRAY_STORAGE, they must be in the button array of the context.
+ * @return Number of keys that have been registered, or -1 when error
+*/
+int32_t flex_button_ctx_touch_register(flex_button_ctx_t *ctx,
+    flex_button_touch_t *touch, flex_button_t *buttons)
+{
+    uint8_t c;
+    int32_t ret = -1;
+
+    if (!touch || !buttons || !touch->usr_count_read || !touch->thresholds ||
+        (touch->channel_num == 0) || (touch->channel_num > FLEX_BTN_TOUCH_MAX_CHANNELS) ||
+        (touch->channel_num > FLEX_BTN_WORD_BITS))
+    {
+        return -1;
+    }
+
+    touch->ready = 0;
+    if (touch->max_on_tick == 0)
+    {
+        touch->max_on_tick = FLEX_BTN_TOUCH_MAX_ON_TICK;
+    }
+    touch->group.usr_group_read = flex_button_touch_group_read;
+
+    if (flex_button_ctx_group_register(ctx, &touch->group) < 0)
+    {
+        return -1;
+    }
+
+    for (c = 0; c < touch->channel_num; c ++)
+    {
+        buttons[c].usr_button_read = NULL;
+        buttons[c].group = &touch->group;
+        buttons[c].group_bit = c;
+        buttons[c].pressed_logic_level = 1; /* group value is 1 when pressed */
+
+        ret = flex_button_ctx_register(ctx, &buttons[c]);
+        if (ret < 0)
+        {
+            return -1;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Register all pads of a capacitive touch group to the default context
+*/
+int32_t flex_button_touch_register(flex_button_touch_t *touch, flex_button_t *buttons)
+{
+    return flex_button_ctx_touch_register(flex_button_default_ctx(), touch, buttons);
+}
@@ -0,0 +1,139 @@
+/**
+ * @File:    flexible_button_touch.h
+ * @Author:  agent
+ * @Date:    2026-10-17
+ * 
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * message:
+ * Capacitive touch backend. The raw counts of all channels are read once per
+ * scan cycle, compared with a drifting baseline of each channel, and the
+ * touched pads are read into flex_button through a button group.
+ * Requires FLEX_BTN_USING_GROUP_READ.
+ * 
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#ifndef __FLEXIBLE_BUTTON_TOUCH_H__
+#define __FLEXIBLE_BUTTON_TOUCH_H__
+
+#include "flexible_button.h"
+
+#ifndef FLEX_BTN_USING_GROUP_READ
+#error "flexible_button_touch requires FLEX_BTN_USING_GROUP_READ"
+#endif
+
+/* Channels of a touch group, up to FLEX_BTN_WORD_BITS */
+#ifndef FLEX_BTN_TOUCH_MAX_CHANNELS
+#define FLEX_BTN_TOUCH_MAX_CHANNELS 32
+#endif
+
+/* The baseline follows the counts with a time constant of 2^shift scans */
+#ifndef FLEX_BTN_TOUCH_FILTER_SHIFT
+#define FLEX_BTN_TOUCH_FILTER_SHIFT 6
+#endif
+
+/* Default 'max_on_tick', 30 s of scans at FLEX_BTN_SCAN_FREQ_HZ, 0 never recalibrates */
+#ifndef FLEX_BTN_TOUCH_MAX_ON_TICK
+#define FLEX_BTN_TOUCH_MAX_ON_TICK (30000 / (1000 / FLEX_BTN_SCAN_FREQ_HZ))
+#endif
+
+/**
+ * flex_button_touch_t
+ * 
+ * @brief Capacitive touch data structure
+ *        Below are members that need to user init before register.
+ * 
+ * @member group
+ *         Internal use.
+ *         Button group of the pads.
+ * 
+ * @member usr_count_read
+ *         User function is used to read the raw counts of all channels,
+ *         'num' counts into 'counts'. A touch raises the count.
+ * 
+ * @member thresholds
+ *         Touch threshold of each channel, the count above the baseline
+ *         at which the pad is touched.
+ * 
+ * @member channel_num
+ *         Number of channels, up to FLEX_BTN_TOUCH_MAX_CHANNELS and FLEX_BTN_WORD_BITS.
+ * 
+ * @member hysteresis
+ *         A touched pad is released when the count falls below its threshold
+ *         minus 'hysteresis', instead of the threshold.
+ * 
+ * @member max_on_tick
+ *         Longest touch in scans, 0 for FLEX_BTN_TOUCH_MAX_ON_TICK.
+ *         A pad touched for longer is taken as a baseline shift, e.g. water
+ *         on the pad or a changed ground, and not as a finger: its baseline
+ *         is set to the count and the pad is released.
+ * 
+ * @member ready
+ *         Internal use.
+ *         The baselines are set, from the first counts read.
+ * 
+ * @member counts
+ *         Internal use, user read-only.
+ *         The last raw counts.
+ * 
+ * @member baseline
+ *         Internal use, user read-only.
+ *         Baseline of each channel, scaled by 2^FLEX_BTN_TOUCH_FILTER_SHIFT.
+ *         It follows the counts while the pad is released, and holds while touched.
+ * 
+ * @member touched
+ *         Internal use, user read-only.
+ *         1 when the pad of the channel is touched.
+ * 
+ * @member on_cnt
+ *         Internal use.
+ *         Scans since the pad of the channel was touched.
+*/
+typedef struct flex_button_touch
+{
+    flex_button_group_t group;
+
+    void (*usr_count_read)(uint16_t *counts, uint8_t num);
+    const uint16_t *thresholds;
+
+    uint8_t channel_num;
+    uint16_t hysteresis;
+    uint16_t max_on_tick;
+
+    uint8_t ready;
+    uint16_t counts[FLEX_BTN_TOUCH_MAX_CHANNELS];
+    int32_t baseline[FLEX_BTN_TOUCH_MAX_CHANNELS];
+    uint8_t touched[FLEX_BTN_TOUCH_MAX_CHANNELS];
+    uint16_t on_cnt[FLEX_BTN_TOUCH_MAX_CHANNELS];
+} flex_button_touch_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+btn_type_t flex_button_touch_filter(flex_button_touch_t *touch, const uint16_t *counts);
+int32_t flex_button_ctx_touch_register(flex_button_ctx_t *ctx,
+    flex_button_touch_t *touch, flex_button_t *buttons);
+int32_t flex_button_touch_register(flex_button_touch_t *touch, flex_button_t *buttons);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __FLEXIBLE_BUTTON_TOUCH_H__ */
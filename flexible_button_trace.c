@@ -0,0 +1,473 @@
+/**
+ * @File:    flexible_button_trace.c
+ * @Author:  agent
+ * @Date:    2026-10-17
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#include "flexible_button_trace.h"
+
+#ifndef NULL
+#define NULL 0
+#endif
+
+/* Bytes of the block header, length and keyframe */
+#define TRACE_HEADER_SIZE (1 + FLEX_BTN_STATUS_WORDS * sizeof(btn_type_t))
+
+/* 'count' of a record followed by a XOR mask */
+#define TRACE_COUNT_MASK  (FLEX_BTN_MAX_NUM + 1)
+
+static uint8_t flex_button_trace_varint_put(uint8_t *p, uint32_t v)
+{
+    uint8_t len = 0;
+
+    while (v >= 0x80)
+    {
+        p[len ++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[len ++] = (uint8_t)v;
+
+    return len;
+}
+
+static uint32_t flex_button_trace_varint_get(const uint8_t *block, uint8_t *pos)
+{
+    uint32_t v = 0;
+    uint8_t shift = 0;
+    uint8_t b;
+
+    while ((*pos < block[0]) && (shift < 32))
+    {
+        b = block[(*pos) ++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+        {
+            break;
+        }
+        shift += 7;
+    }
+
+    return v;
+}
+
+static uint8_t flex_button_trace_words_put(uint8_t *p, const btn_type_t *words)
+{
+    uint8_t w, k;
+    uint8_t len = 0;
+
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        for (k = 0; k < sizeof(btn_type_t); k ++)
+        {
+            p[len ++] = (uint8_t)(words[w] >> (k * 8));
+        }
+    }
+
+    return len;
+}
+
+static void flex_button_trace_words_get(const uint8_t *block, uint8_t *pos, btn_type_t *words)
+{
+    uint8_t w, k;
+
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        words[w] = 0;
+        for (k = 0; k < sizeof(btn_type_t); k ++)
+        {
+            if (*pos < block[0])
+            {
+                words[w] |= (btn_type_t)block[(*pos) ++] << (k * 8);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Append a record to the newest block, start a new block when it is full.
+ *
+ * @param trace: trace structure instance
+ * @param record: the encoded record
+ * @param len: record length
+ * @return none
+*/
+static void flex_button_trace_append(flex_button_trace_t *trace, const uint8_t *record, uint8_t len)
+{
+    uint8_t *block = NULL;
+    uint8_t k;
+
+    if (trace->count)
+    {
+        block = &trace->buf[((trace->first + trace->count - 1) % trace->block_num) * FLEX_BTN_TRACE_BLOCK_SIZE];
+    }
+
+    if (!block || (block[0] + len > FLEX_BTN_TRACE_BLOCK_SIZE))
+    {
+        if (trace->count < trace->block_num)
+        {
+            trace->count ++;
+        }
+        else
+        {
+            trace->first = (trace->first + 1) % trace->block_num; /* overwrite the oldest */
+        }
+
+        block = &trace->buf[((trace->first + trace->count - 1) % trace->block_num) * FLEX_BTN_TRACE_BLOCK_SIZE];
+        block[0] = 1 + flex_button_trace_words_put(&block[1], trace->last);
+    }
+
+    for (k = 0; k < len; k ++)
+    {
+        block[block[0] + k] = record[k];
+    }
+    block[0] += len;
+}
+
+/**
+ * @brief Write the pending scans and the change of the next scan.
+ *
+ * @param trace: trace structure instance
+ * @param change: XOR of the next pressing state and the last one, NULL when none
+ * @return none
+*/
+static void flex_button_trace_write(flex_button_trace_t *trace, const btn_type_t *change)
+{
+    uint8_t record[5 + 2 + FLEX_BTN_STATUS_WORDS * sizeof(btn_type_t)];
+    uint8_t len;
+    uint16_t count = 0;
+    uint16_t bytes = 0;
+    uint16_t i;
+    uint8_t w;
+    btn_type_t x;
+
+    len = flex_button_trace_varint_put(record, trace->run);
+    trace->run = 0;
+
+    if (change)
+    {
+        for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+        {
+            for (x = change[w], i = w * FLEX_BTN_WORD_BITS; x; x >>= 1, i ++)
+            {
+                if (x & 1)
+                {
+                    count ++;
+                    bytes += (i < 0x80) ? 1 : 2;
+                }
+            }
+        }
+    }
+
+    if (count == 0)
+    {
+        len += flex_button_trace_varint_put(&record[len], 0);
+    }
+    else if (bytes >= FLEX_BTN_STATUS_WORDS * sizeof(btn_type_t))
+    {
+        /* Many buttons changed, the mask is shorter */
+        len += flex_button_trace_varint_put(&record[len], TRACE_COUNT_MASK);
+        len += flex_button_trace_words_put(&record[len], change);
+    }
+    else
+    {
+        len += flex_button_trace_varint_put(&record[len], count);
+        for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+        {
+            for (x = change[w], i = w * FLEX_BTN_WORD_BITS; x; x >>= 1, i ++)
+            {
+                if (x & 1)
+                {
+                    len += flex_button_trace_varint_put(&record[len], i);
+                }
+            }
+        }
+    }
+
+    flex_button_trace_append(trace, record, len);
+}
+
+/**
+ * flex_button_trace_init
+ *
+ * @brief Initialize an empty trace ring.
+ *
+ * @param trace: trace structure instance
+ * @param buf: ring buffer
+ * @param size: bytes of the buffer, at least FLEX_BTN_TRACE_BLOCK_SIZE
+ * @return Number of blocks, or -1 when error
+*/
+int32_t flex_button_trace_init(flex_button_trace_t *trace, uint8_t *buf, uint32_t size)
+{
+    uint8_t w;
+
+    if (!trace || !buf || (size < FLEX_BTN_TRACE_BLOCK_SIZE))
+    {
+        return -1;
+    }
+
+    size /= FLEX_BTN_TRACE_BLOCK_SIZE;
+    trace->buf = buf;
+    trace->block_num = (size > 0xFFFF) ? 0xFFFF : (uint16_t)size;
+    trace->first = 0;
+    trace->count = 0;
+    trace->run = 0;
+
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        trace->last[w] = 0; /* all released */
+    }
+
+    return trace->block_num;
+}
+
+/**
+ * flex_button_trace_load
+ *
+ * @brief Attach a trace saved from 'flex_button_trace_block', oldest block first,
+ *        to read it back.
+ *
+ * @param trace: trace structure instance
+ * @param buf: the saved blocks
+ * @param size: bytes of the saved blocks
+ * @return Number of blocks, or -1 when it is not a trace
+*/
+int32_t flex_button_trace_load(flex_button_trace_t *trace, uint8_t *buf, uint32_t size)
+{
+    int32_t num = flex_button_trace_init(trace, buf, size);
+    uint16_t i;
+    uint8_t len;
+
+    if (num < 0)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < trace->block_num; i ++)
+    {
+        len = buf[i * FLEX_BTN_TRACE_BLOCK_SIZE];
+        if (len < TRACE_HEADER_SIZE)
+        {
+            return -1;
+        }
+#if FLEX_BTN_TRACE_BLOCK_SIZE < 255
+        if (len > FLEX_BTN_TRACE_BLOCK_SIZE)
+        {
+            return -1;
+        }
+#endif
+    }
+    trace->count = trace->block_num;
+
+    return num;
+}
+
+/**
+ * flex_button_trace_record
+ *
+ * @brief Record the pressing state of one scan.
+ *        It is a flex_button_trace_hook_t, set it with
+ *        flex_button_trace_hook(flex_button_trace_record, &trace).
+ *
+ * @param trace: trace structure instance
+ * @param pressed: pressing state of the buttons, FLEX_BTN_STATUS_WORDS words
+ * @return none
+*/
+void flex_button_trace_record(void *trace, const btn_type_t *pressed)
+{
+    flex_button_trace_t *t = (flex_button_trace_t *)trace;
+    btn_type_t change[FLEX_BTN_STATUS_WORDS];
+    btn_type_t differ = 0;
+    uint8_t w;
+
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        change[w] = pressed[w] ^ t->last[w];
+        differ |= change[w];
+    }
+
+    if (!differ)
+    {
+        /* Same as the last scan, only counted */
+        if (++ t->run == 0xFFFFFFFF)
+        {
+            flex_button_trace_write(t, NULL);
+        }
+        return;
+    }
+
+    flex_button_trace_write(t, change);
+
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        t->last[w] = pressed[w];
+    }
+}
+
+/**
+ * flex_button_trace_flush
+ *
+ * @brief Write the counted scans, before reading or saving the trace.
+ *
+ * @param trace: trace structure instance
+ * @return none
+*/
+void flex_button_trace_flush(flex_button_trace_t *trace)
+{
+    if (trace->run)
+    {
+        flex_button_trace_write(trace, NULL);
+    }
+}
+
+/**
+ * flex_button_trace_block
+ *
+ * @brief Get a block of the trace to save it, e.g. send them all to the host
+ *        from n = 0 until NULL. Stop recording and flush the trace before.
+ *
+ * @param trace: trace structure instance
+ * @param n: block number, 0 is the oldest
+ * @return The block of FLEX_BTN_TRACE_BLOCK_SIZE bytes, NULL when n is out of range
+*/
+const uint8_t *flex_button_trace_block(const flex_button_trace_t *trace, uint16_t n)
+{
+    if (n >= trace->count)
+    {
+        return NULL;
+    }
+
+    return &trace->buf[((trace->first + n) % trace->block_num) * FLEX_BTN_TRACE_BLOCK_SIZE];
+}
+
+/**
+ * flex_button_trace_reader_init
+ *
+ * @brief Start reading a trace from the oldest scan.
+ *
+ * @param reader: reader structure instance
+ * @param trace: trace structure instance
+ * @return none
+*/
+void flex_button_trace_reader_init(flex_button_trace_reader_t *reader, const flex_button_trace_t *trace)
+{
+    uint8_t w;
+
+    reader->trace = trace;
+    reader->block = 0;
+    reader->pos = 0;
+    reader->change_pending = 0;
+    reader->skip = 0;
+
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        reader->pressed[w] = 0;
+        reader->change[w] = 0;
+    }
+}
+
+/**
+ * flex_button_trace_read
+ *
+ * @brief Read the pressing state of the next scan, to pass it to flex_button_replay.
+ *        When the ring has wrapped, the oldest scans are lost and the
+ *        buttons pressed at the start of the trace are reported as new presses.
+ *
+ * @param reader: reader structure instance
+ * @param pressed: pressing state of the buttons, FLEX_BTN_STATUS_WORDS words
+ * @return 1 when a scan is read, 0 at the end of the trace
+*/
+uint8_t flex_button_trace_read(flex_button_trace_reader_t *reader, btn_type_t *pressed)
+{
+    const uint8_t *block;
+    uint32_t count;
+    uint32_t i;
+    uint8_t w;
+
+    while (!reader->skip && !reader->change_pending)
+    {
+        block = flex_button_trace_block(reader->trace, reader->block);
+        if (!block)
+        {
+            return 0;
+        }
+
+        if (reader->pos == 0)
+        {
+            reader->pos = 1;
+            flex_button_trace_words_get(block, &reader->pos, reader->pressed);
+        }
+
+        if (reader->pos >= block[0])
+        {
+            reader->block ++;
+            reader->pos = 0;
+            continue;
+        }
+
+        reader->skip = flex_button_trace_varint_get(block, &reader->pos);
+        count = flex_button_trace_varint_get(block, &reader->pos);
+
+        if (count == TRACE_COUNT_MASK)
+        {
+            flex_button_trace_words_get(block, &reader->pos, reader->change);
+            reader->change_pending = 1;
+        }
+        else if (count > 0)
+        {
+            for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+            {
+                reader->change[w] = 0;
+            }
+
+            while (count -- && (reader->pos < block[0]))
+            {
+                i = flex_button_trace_varint_get(block, &reader->pos);
+                if (i < FLEX_BTN_MAX_NUM)
+                {
+                    reader->change[i / FLEX_BTN_WORD_BITS] |= (btn_type_t)1 << (i % FLEX_BTN_WORD_BITS);
+                }
+            }
+            reader->change_pending = 1;
+        }
+    }
+
+    if (reader->skip)
+    {
+        reader->skip --;
+    }
+    else
+    {
+        for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+        {
+            reader->pressed[w] ^= reader->change[w];
+        }
+        reader->change_pending = 0;
+    }
+
+    for (w = 0; w < FLEX_BTN_STATUS_WORDS; w ++)
+    {
+        pressed[w] = reader->pressed[w];
+    }
+
+    return 1;
+}
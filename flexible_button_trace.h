@@ -0,0 +1,134 @@
+/**
+ * @File:    flexible_button_trace.h
+ * @Author:  agent
+ * @Date:    2026-10-17
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * message:
+ * Records the pressing state of each scan into a small RAM ring, and reads
+ * it back for flex_button_ctx_replay, e.g. on the host with tools/flex_button_replay.c.
+ * Requires FLEX_BTN_USING_TRACE.
+ *
+ * Trace format:
+ * The ring is made of FLEX_BTN_TRACE_BLOCK_SIZE byte blocks, when it is full
+ * the oldest block is overwritten. Each block is
+ *     length      1 byte, used bytes of the block
+ *     keyframe    pressing state at the start of the block, FLEX_BTN_STATUS_WORDS
+ *                 little-endian words
+ *     records     until 'length'
+ * Each record is
+ *     skip        varint, scans with the same pressing state
+ *     count       varint, number of buttons that change in the next scan,
+ *                 FLEX_BTN_MAX_NUM + 1 when a XOR mask follows instead
+ *     changes     'count' varint button indexes, or the XOR mask words
+ * A record with 'count' 0 only holds the 'skip' scans.
+ * Varints are little-endian, 7 bits per byte, bit 7 set when more bytes follow.
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#ifndef __FLEXIBLE_BUTTON_TRACE_H__
+#define __FLEXIBLE_BUTTON_TRACE_H__
+
+#include "flexible_button.h"
+
+#ifndef FLEX_BTN_USING_TRACE
+#error "flexible_button_trace requires FLEX_BTN_USING_TRACE"
+#endif
+
+/* Bytes of each block, holds at least one keyframe and the largest record */
+#ifndef FLEX_BTN_TRACE_BLOCK_SIZE
+#if FLEX_BTN_STATUS_WORDS < 7
+#define FLEX_BTN_TRACE_BLOCK_SIZE 64
+#else
+#define FLEX_BTN_TRACE_BLOCK_SIZE 255
+#endif
+#endif
+
+#if (FLEX_BTN_TRACE_BLOCK_SIZE > 255) || \
+    (FLEX_BTN_TRACE_BLOCK_SIZE < 8 + 8 * FLEX_BTN_STATUS_WORDS)
+#error "FLEX_BTN_TRACE_BLOCK_SIZE must be 8 + 8 * FLEX_BTN_STATUS_WORDS to 255"
+#endif
+
+/**
+ * flex_button_trace_t
+ *
+ * @brief Trace ring data structure
+ *        All members are internal use, initialize it with flex_button_trace_init.
+ *
+ * @member buf, block_num
+ *         The ring, 'block_num' blocks of FLEX_BTN_TRACE_BLOCK_SIZE bytes.
+ *
+ * @member first, count
+ *         The oldest block and the number of used blocks.
+ *
+ * @member run
+ *         Scans with the same pressing state, not written yet.
+ *
+ * @member last
+ *         Pressing state of the last recorded scan.
+ *
+*/
+typedef struct flex_button_trace
+{
+    uint8_t *buf;
+    uint16_t block_num;
+    uint16_t first;
+    uint16_t count;
+
+    uint32_t run;
+    btn_type_t last[FLEX_BTN_STATUS_WORDS];
+} flex_button_trace_t;
+
+/**
+ * flex_button_trace_reader_t
+ *
+ * @brief Internal use.
+ *        Reads the scans of a trace from the oldest.
+*/
+typedef struct flex_button_trace_reader
+{
+    const flex_button_trace_t *trace;
+    uint16_t block;
+    uint8_t pos;
+    uint8_t change_pending;
+
+    uint32_t skip;
+    btn_type_t pressed[FLEX_BTN_STATUS_WORDS];
+    btn_type_t change[FLEX_BTN_STATUS_WORDS];
+} flex_button_trace_reader_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int32_t flex_button_trace_init(flex_button_trace_t *trace, uint8_t *buf, uint32_t size);
+int32_t flex_button_trace_load(flex_button_trace_t *trace, uint8_t *buf, uint32_t size);
+void flex_button_trace_record(void *trace, const btn_type_t *pressed);
+void flex_button_trace_flush(flex_button_trace_t *trace);
+const uint8_t *flex_button_trace_block(const flex_button_trace_t *trace, uint16_t n);
+
+void flex_button_trace_reader_init(flex_button_trace_reader_t *reader, const flex_button_trace_t *trace);
+uint8_t flex_button_trace_read(flex_button_trace_reader_t *reader, btn_type_t *pressed);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __FLEXIBLE_BUTTON_TRACE_H__ */
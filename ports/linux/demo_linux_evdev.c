@@ -0,0 +1,199 @@
+/**
+ * @File:    demo_linux_evdev.c
+ * @Author:  agent
+ * @Date:    2026-10-17
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * message:
+ * This demo runs on Linux with the evdev backend. The Enter, Space and Esc
+ * keys of the given input devices are the buttons, their events are printed,
+ * and with -u a long press of Esc sends KEY_POWER and a double click of
+ * Enter sends KEY_PLAYPAUSE from a uinput device.
+ *
+ * Build, in the ports/linux directory:
+ *     gcc -O2 -I../.. -I. -DFLEX_BTN_USING_TICKLESS ../../flexible_button.c \
+ *         flexible_button_evdev.c demo_linux_evdev.c -o demo_linux_evdev
+ *
+ * Usage:
+ *     ./demo_linux_evdev [-g] [-u] /dev/input/eventX [/dev/input/eventY ...]
+ *     -g: grab the devices, the keys do not reach the other readers
+ *     -u: send the gestures from a uinput device
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <linux/input.h>
+
+#include "flexible_button_evdev.h"
+
+#define ENUM_TO_STR(e) (#e)
+
+typedef enum
+{
+    USER_BUTTON_ENTER = 0,
+    USER_BUTTON_SPACE,
+    USER_BUTTON_ESC,
+    USER_BUTTON_MAX
+} user_button_t;
+
+static char *enum_event_string[] = {
+    ENUM_TO_STR(FLEX_BTN_PRESS_DOWN),
+    ENUM_TO_STR(FLEX_BTN_PRESS_CLICK),
+    ENUM_TO_STR(FLEX_BTN_PRESS_DOUBLE_CLICK),
+    ENUM_TO_STR(FLEX_BTN_PRESS_REPEAT_CLICK),
+    ENUM_TO_STR(FLEX_BTN_PRESS_SHORT_START),
+    ENUM_TO_STR(FLEX_BTN_PRESS_SHORT_UP),
+    ENUM_TO_STR(FLEX_BTN_PRESS_LONG_START),
+    ENUM_TO_STR(FLEX_BTN_PRESS_LONG_UP),
+    ENUM_TO_STR(FLEX_BTN_PRESS_LONG_HOLD),
+    ENUM_TO_STR(FLEX_BTN_PRESS_LONG_HOLD_UP),
+    ENUM_TO_STR(FLEX_BTN_PRESS_COMBO),
+    ENUM_TO_STR(FLEX_BTN_PRESS_REPEAT),
+    ENUM_TO_STR(FLEX_BTN_PRESS_STEP),
+    ENUM_TO_STR(FLEX_BTN_PRESS_REPEAT_UP),
+    ENUM_TO_STR(FLEX_BTN_PRESS_MAX),
+    ENUM_TO_STR(FLEX_BTN_PRESS_NONE),
+};
+
+static char *enum_btn_id_string[] = {
+    ENUM_TO_STR(USER_BUTTON_ENTER),
+    ENUM_TO_STR(USER_BUTTON_SPACE),
+    ENUM_TO_STR(USER_BUTTON_ESC),
+    ENUM_TO_STR(USER_BUTTON_MAX),
+};
+
+static const flex_button_evdev_key_t user_keys[USER_BUTTON_MAX] = {
+    { KEY_ENTER, USER_BUTTON_ENTER },
+    { KEY_SPACE, USER_BUTTON_SPACE },
+    { KEY_ESC,   USER_BUTTON_ESC },
+};
+
+static const flex_button_evdev_gesture_t user_gestures[] = {
+    { USER_BUTTON_ESC,   FLEX_BTN_PRESS_LONG_START,   KEY_POWER },
+    { USER_BUTTON_ENTER, FLEX_BTN_PRESS_DOUBLE_CLICK, KEY_PLAYPAUSE },
+};
+
+static flex_button_ctx_t user_ctx;
+static flex_button_t user_button[USER_BUTTON_MAX];
+static flex_button_evdev_t user_evdev;
+
+static uint8_t common_btn_read(void *arg)
+{
+    (void)arg;
+
+    return 0; /* the levels come from the input events */
+}
+
+static void common_btn_evt_cb(void *arg)
+{
+    flex_button_t *btn = (flex_button_t *)arg;
+
+    printf("[%8u ms] id: [%d - %s]  event: [%d - %30s]  repeat: %d\n",
+        (unsigned)flex_button_evdev_now(&user_evdev),
+        btn->id, enum_btn_id_string[btn->id],
+        btn->event, enum_event_string[btn->event],
+        btn->click_cnt);
+
+    if (flex_button_evdev_emit(&user_evdev, btn->id, btn->event) > 0)
+    {
+        printf("  gesture sent\n");
+    }
+    fflush(stdout);
+}
+
+static void user_button_init(void)
+{
+    int i;
+
+    memset(&user_button[0], 0x0, sizeof(user_button));
+    flex_button_ctx_init(&user_ctx);
+
+    for (i = 0; i < USER_BUTTON_MAX; i ++)
+    {
+        user_button[i].id = i;
+        user_button[i].usr_button_read = common_btn_read;
+        user_button[i].cb = common_btn_evt_cb;
+        user_button[i].pressed_logic_level = 1;
+        user_button[i].short_press_start_tick = FLEX_MS_TO_SCAN_CNT(1500);
+        user_button[i].long_press_start_tick = FLEX_MS_TO_SCAN_CNT(3000);
+        user_button[i].long_hold_start_tick = FLEX_MS_TO_SCAN_CNT(4500);
+
+        flex_button_ctx_register(&user_ctx, &user_button[i]);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint8_t grab = 0, uinput = 0;
+    int opened = 0;
+    int i;
+
+    user_button_init();
+
+    if (flex_button_evdev_init(&user_evdev, &user_ctx, user_keys, USER_BUTTON_MAX) < 0)
+    {
+        perror("flex_button_evdev_init");
+        return 1;
+    }
+
+    for (i = 1; i < argc; i ++)
+    {
+        if (strcmp(argv[i], "-g") == 0)
+        {
+            grab = 1;
+        }
+        else if (strcmp(argv[i], "-u") == 0)
+        {
+            uinput = 1;
+        }
+        else if (flex_button_evdev_open(&user_evdev, argv[i], grab) < 0)
+        {
+            perror(argv[i]);
+        }
+        else
+        {
+            opened ++;
+        }
+    }
+
+    if (opened == 0)
+    {
+        fprintf(stderr, "usage: %s [-g] [-u] /dev/input/eventX ...\n", argv[0]);
+        flex_button_evdev_deinit(&user_evdev);
+        return 1;
+    }
+
+    if (uinput && (flex_button_evdev_uinput_open(&user_evdev, "flex_button",
+        user_gestures, sizeof(user_gestures) / sizeof(user_gestures[0])) < 0))
+    {
+        perror("/dev/uinput");
+    }
+
+    /* Sleeps until a key changes or a button times out */
+    while (flex_button_evdev_poll(&user_evdev, -1) >= 0)
+    {
+    }
+
+    flex_button_evdev_deinit(&user_evdev);
+
+    return 0;
+}
@@ -0,0 +1,471 @@
+/**
+ * @File:    flex_button_evdev_check.c
+ * @Author:  agent
+ * @Date:    2026-10-17
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * message:
+ * End-to-end check of the evdev backend with a uinput virtual keyboard.
+ * The check creates a keyboard with uinput, opens its event device with
+ * flex_button_evdev_open, and types a click, a double click, a long hold and
+ * a key held while the keyboard is unplugged. The button events must be the
+ * expected ones, and the double click must come out of the gesture uinput
+ * device of flex_button_evdev_uinput_open as KEY_PLAYPAUSE.
+ * Needs write access to /dev/uinput, e.g. root, it exits with 77 (skipped)
+ * without it. With -p the same keys are sent through a pipe instead, which
+ * checks the backend without uinput, but not the gesture device.
+ *
+ * Build, in the ports/linux directory:
+ *     gcc -O2 -I../.. -I. -DFLEX_BTN_USING_TICKLESS ../../flexible_button.c \
+ *         flexible_button_evdev.c flex_button_evdev_check.c -o flex_button_evdev_check
+ *
+ * Usage:
+ *     ./flex_button_evdev_check [-p]
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#define _DEFAULT_SOURCE
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+#include <linux/uinput.h>
+
+#include "flexible_button_evdev.h"
+
+#if defined(FLEX_BTN_USING_EVENT_QUEUE) || defined(FLEX_BTN_USING_EVENT_BATCH)
+#error "The check reads the events in the button callback"
+#endif
+
+/* Exit code of a skipped check */
+#define CHECK_SKIP        77
+
+/* Time for udev to create the device node */
+#define CHECK_NODE_WAIT_MS 2000
+
+#define CHECK_UNPLUG      0xFF
+
+#define CHECK_EVENT_MAX   32
+
+typedef struct
+{
+    uint32_t time;  /* ms from the start */
+    uint16_t code;  /* key code, or CHECK_UNPLUG */
+    uint8_t value;  /* 1 down, 0 up */
+} check_step_t;
+
+typedef struct
+{
+    uint8_t id;
+    uint8_t event;
+} check_event_t;
+
+enum
+{
+    CHECK_BUTTON_A = 0,
+    CHECK_BUTTON_B,
+    CHECK_BUTTON_MAX
+};
+
+static const flex_button_evdev_key_t check_keys[CHECK_BUTTON_MAX] = {
+    { KEY_A, CHECK_BUTTON_A },
+    { KEY_B, CHECK_BUTTON_B },
+};
+
+static const flex_button_evdev_gesture_t check_gestures[] = {
+    { CHECK_BUTTON_A, FLEX_BTN_PRESS_DOUBLE_CLICK, KEY_PLAYPAUSE },
+};
+
+/* Click, double click, long hold, then A held while the keyboard is unplugged */
+static const check_step_t check_steps[] = {
+    {  100, KEY_A, 1 }, {  200, KEY_A, 0 },
+    { 1000, KEY_A, 1 }, { 1080, KEY_A, 0 }, { 1160, KEY_A, 1 }, { 1240, KEY_A, 0 },
+    { 2000, KEY_B, 1 }, { 3500, KEY_B, 0 },
+    { 4000, KEY_A, 1 }, { 4450, CHECK_UNPLUG, 0 },
+};
+
+#define CHECK_END_MS 5000
+
+static const check_event_t check_expected[] = {
+    { CHECK_BUTTON_A, FLEX_BTN_PRESS_DOWN },
+    { CHECK_BUTTON_A, FLEX_BTN_PRESS_CLICK },
+    { CHECK_BUTTON_A, FLEX_BTN_PRESS_DOWN },
+    { CHECK_BUTTON_A, FLEX_BTN_PRESS_DOUBLE_CLICK },
+    { CHECK_BUTTON_B, FLEX_BTN_PRESS_DOWN },
+    { CHECK_BUTTON_B, FLEX_BTN_PRESS_SHORT_START },
+    { CHECK_BUTTON_B, FLEX_BTN_PRESS_LONG_START },
+    { CHECK_BUTTON_B, FLEX_BTN_PRESS_LONG_HOLD },
+    { CHECK_BUTTON_B, FLEX_BTN_PRESS_LONG_HOLD_UP },
+    { CHECK_BUTTON_A, FLEX_BTN_PRESS_DOWN },
+    { CHECK_BUTTON_A, FLEX_BTN_PRESS_SHORT_START },
+    { CHECK_BUTTON_A, FLEX_BTN_PRESS_SHORT_UP },
+};
+
+static flex_button_ctx_t check_ctx;
+static flex_button_t check_button[CHECK_BUTTON_MAX];
+static flex_button_evdev_t check_evdev;
+
+static check_event_t check_events[CHECK_EVENT_MAX];
+static uint32_t check_event_num;
+
+static uint8_t check_btn_read(void *arg)
+{
+    (void)arg;
+
+    return 0; /* the levels come from the input events */
+}
+
+static void check_btn_evt_cb(void *arg)
+{
+    flex_button_t *btn = (flex_button_t *)arg;
+
+    if (check_event_num < CHECK_EVENT_MAX)
+    {
+        check_events[check_event_num].id = btn->id;
+        check_events[check_event_num].event = btn->event;
+    }
+    check_event_num ++;
+
+    flex_button_evdev_emit(&check_evdev, btn->id, btn->event);
+}
+
+static void check_buttons_init(void)
+{
+    uint8_t i;
+
+    memset(check_button, 0, sizeof(check_button));
+    flex_button_ctx_init(&check_ctx);
+
+    for (i = 0; i < CHECK_BUTTON_MAX; i ++)
+    {
+        check_button[i].id = i;
+        check_button[i].usr_button_read = check_btn_read;
+        check_button[i].cb = check_btn_evt_cb;
+        check_button[i].pressed_logic_level = 1;
+        check_button[i].short_press_start_tick = FLEX_MS_TO_SCAN_CNT(300);
+        check_button[i].long_press_start_tick = FLEX_MS_TO_SCAN_CNT(600);
+        check_button[i].long_hold_start_tick = FLEX_MS_TO_SCAN_CNT(900);
+        flex_button_ctx_register(&check_ctx, &check_button[i]);
+    }
+}
+
+/**
+ * @brief Find the event device of a uinput device, and open it.
+ *
+ * @param uinput_fd: the uinput device
+ * @param path: receives the path of the event device
+ * @param size: size of 'path'
+ * @return The fd of the event device, -1 on error
+*/
+static int check_uinput_node(int uinput_fd, char *path, size_t size)
+{
+    char sysname[64];
+    char dir_path[128];
+    struct dirent *entry;
+    DIR *dir;
+    int waited, fd;
+
+    if (ioctl(uinput_fd, UI_GET_SYSNAME(sizeof(sysname)), sysname) < 0)
+    {
+        return -1;
+    }
+    snprintf(dir_path, sizeof(dir_path), "/sys/devices/virtual/input/%s", sysname);
+
+    for (waited = 0; waited < CHECK_NODE_WAIT_MS; waited += 10)
+    {
+        dir = opendir(dir_path);
+        if (dir)
+        {
+            while ((entry = readdir(dir)) != NULL)
+            {
+                if (strncmp(entry->d_name, "event", 5) == 0)
+                {
+                    snprintf(path, size, "/dev/input/%.32s", entry->d_name);
+                    break;
+                }
+            }
+            closedir(dir);
+
+            if (entry)
+            {
+                fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+                if (fd >= 0)
+                {
+                    return fd;
+                }
+            }
+        }
+        usleep(10 * 1000);
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Create the uinput keyboard with the keys of the check.
+ *
+ * @return The uinput fd, -1 on error
+*/
+static int check_keyboard_create(void)
+{
+    struct uinput_setup setup;
+    uint8_t k;
+    int fd;
+
+    fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    if (ioctl(fd, UI_SET_EVBIT, EV_KEY) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    for (k = 0; k < CHECK_BUTTON_MAX; k ++)
+    {
+        if (ioctl(fd, UI_SET_KEYBIT, check_keys[k].code) < 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+
+    memset(&setup, 0, sizeof(setup));
+    setup.id.bustype = BUS_VIRTUAL;
+    strncpy(setup.name, "flex_button_check_keyboard", UINPUT_MAX_NAME_SIZE - 1);
+    if ((ioctl(fd, UI_DEV_SETUP, &setup) < 0) || (ioctl(fd, UI_DEV_CREATE) < 0))
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static int check_key_send(int fd, uint16_t code, uint8_t value)
+{
+    struct input_event ev[2];
+
+    memset(ev, 0, sizeof(ev));
+    ev[0].type = EV_KEY;
+    ev[0].code = code;
+    ev[0].value = value;
+    ev[1].type = EV_SYN;
+    ev[1].code = SYN_REPORT;
+
+    return (write(fd, ev, sizeof(ev)) == (ssize_t)sizeof(ev)) ? 0 : -1;
+}
+
+/**
+ * @brief Run the steps, the backend is polled until the time of each step.
+ *
+ * @param key_fd: the uinput keyboard, or the write end of the pipe
+ * @param uinput: 1 for a uinput keyboard
+ * @return 0 on success, -1 on error
+*/
+static int check_run(int key_fd, uint8_t uinput)
+{
+    uint32_t start = flex_button_evdev_now(&check_evdev);
+    uint32_t elapsed;
+    size_t s;
+
+    for (s = 0; s <= sizeof(check_steps) / sizeof(check_steps[0]); s ++)
+    {
+        uint32_t at = (s < sizeof(check_steps) / sizeof(check_steps[0])) ? check_steps[s].time : CHECK_END_MS;
+
+        while ((elapsed = flex_button_evdev_now(&check_evdev) - start) < at)
+        {
+            if (flex_button_evdev_poll(&check_evdev, (int)(at - elapsed)) < 0)
+            {
+                return -1;
+            }
+        }
+
+        if (s == sizeof(check_steps) / sizeof(check_steps[0]))
+        {
+            break;
+        }
+
+        if (check_steps[s].code == CHECK_UNPLUG)
+        {
+            if (uinput)
+            {
+                ioctl(key_fd, UI_DEV_DESTROY);
+            }
+            close(key_fd);
+        }
+        else if (check_key_send(key_fd, check_steps[s].code, check_steps[s].value) < 0)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Read the key codes sent by the gesture device.
+ *
+ * @param fd: the event device of the gesture device
+ * @return 0 when KEY_PLAYPAUSE was pressed and released once, 1 otherwise
+*/
+static int check_gesture_output(int fd)
+{
+    struct input_event ev;
+    int down = 0, up = 0;
+
+    while (read(fd, &ev, sizeof(ev)) == (ssize_t)sizeof(ev))
+    {
+        if ((ev.type == EV_KEY) && (ev.code == KEY_PLAYPAUSE))
+        {
+            if (ev.value == 1)
+            {
+                down ++;
+            }
+            else if (ev.value == 0)
+            {
+                up ++;
+            }
+        }
+    }
+
+    if ((down != 1) || (up != 1))
+    {
+        fprintf(stderr, "gesture device: KEY_PLAYPAUSE down %d up %d, expected 1 and 1\n", down, up);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int check_events_compare(void)
+{
+    uint32_t num = sizeof(check_expected) / sizeof(check_expected[0]);
+    uint32_t i;
+    int result = 0;
+
+    if (check_event_num != num)
+    {
+        fprintf(stderr, "%u events, expected %u\n", (unsigned)check_event_num, (unsigned)num);
+        result = 1;
+    }
+
+    for (i = 0; (i < check_event_num) && (i < CHECK_EVENT_MAX); i ++)
+    {
+        uint8_t ok = (i < num) && (check_events[i].id == check_expected[i].id) &&
+            (check_events[i].event == check_expected[i].event);
+
+        fprintf(ok ? stdout : stderr, "%2u: id %u event %2u%s\n", (unsigned)i,
+            check_events[i].id, check_events[i].event, ok ? "" : "  <- unexpected");
+        if (!ok)
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    uint8_t uinput = !((argc > 1) && (strcmp(argv[1], "-p") == 0));
+    char path[64];
+    int key_fd = -1, out_fd = -1;
+    int pipe_fd[2];
+    int result;
+
+    check_buttons_init();
+    if (flex_button_evdev_init(&check_evdev, &check_ctx, check_keys, CHECK_BUTTON_MAX) < 0)
+    {
+        perror("flex_button_evdev_init");
+        return 1;
+    }
+
+    if (uinput)
+    {
+        key_fd = check_keyboard_create();
+        if (key_fd < 0)
+        {
+            printf("skipped, no uinput: %s\n", strerror(errno));
+            flex_button_evdev_deinit(&check_evdev);
+            return CHECK_SKIP;
+        }
+
+        /* Only the path is needed, the backend opens the device itself */
+        out_fd = check_uinput_node(key_fd, path, sizeof(path));
+        if (out_fd >= 0)
+        {
+            close(out_fd);
+            out_fd = -1;
+        }
+        if (flex_button_evdev_open(&check_evdev, path, 1) < 0)
+        {
+            fprintf(stderr, "can not open the event device of the keyboard\n");
+            return 1;
+        }
+
+        if ((flex_button_evdev_uinput_open(&check_evdev, "flex_button_check_gestures", check_gestures,
+            sizeof(check_gestures) / sizeof(check_gestures[0])) < 0) ||
+            ((out_fd = check_uinput_node(check_evdev.uinput_fd, path, sizeof(path))) < 0))
+        {
+            fprintf(stderr, "can not create the gesture device\n");
+            return 1;
+        }
+
+        /* The keyboard is ready once its events reach the backend */
+        usleep(100 * 1000);
+    }
+    else
+    {
+        if ((pipe(pipe_fd) < 0) || (flex_button_evdev_add_fd(&check_evdev, pipe_fd[0]) < 0))
+        {
+            perror("pipe");
+            return 1;
+        }
+        key_fd = pipe_fd[1];
+    }
+
+    if (check_run(key_fd, uinput) < 0)
+    {
+        perror("check_run");
+        return 1;
+    }
+
+    result = check_events_compare();
+    if (out_fd >= 0)
+    {
+        result |= check_gesture_output(out_fd);
+        close(out_fd);
+    }
+
+    flex_button_evdev_deinit(&check_evdev);
+
+    printf("%s\n", result ? "FAILED" : (uinput ? "uinput OK" : "pipe OK"));
+
+    return result;
+}
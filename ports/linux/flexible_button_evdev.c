@@ -0,0 +1,597 @@
+/**
+ * @File:    flexible_button_evdev.c
+ * @Author:  agent
+ * @Date:    2026-10-17
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+#include <linux/uinput.h>
+
+#include "flexible_button_evdev.h"
+
+/* Kernels before 4.16 have no input_event_sec */
+#ifndef input_event_sec
+#define input_event_sec  time.tv_sec
+#define input_event_usec time.tv_usec
+#endif
+
+#define EVDEV_WORD(k) ((k) / FLEX_BTN_WORD_BITS)
+#define EVDEV_BIT(k)  ((btn_type_t)1 << ((k) % FLEX_BTN_WORD_BITS))
+
+#define EVDEV_TEST_BIT(bits, n) (((bits)[(n) / 8] >> ((n) % 8)) & 1)
+
+static uint64_t flex_button_evdev_clock_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * flex_button_evdev_now
+ *
+ * @brief The current time of the context, in milliseconds.
+ *
+ * @param evdev: evdev backend
+ * @return Milliseconds since flex_button_evdev_init
+*/
+uint32_t flex_button_evdev_now(flex_button_evdev_t *evdev)
+{
+    return (uint32_t)(flex_button_evdev_clock_ms() - evdev->base_ms);
+}
+
+/**
+ * flex_button_evdev_init
+ *
+ * @brief Initialize the backend, the buttons must be registered to 'ctx'.
+ *
+ * @param evdev: evdev backend
+ * @param ctx: button context
+ * @param keys: key code of each button, must stay valid
+ * @param key_num: number of keys, up to FLEX_BTN_MAX_NUM
+ * @return 0 on success, -1 on error
+*/
+int flex_button_evdev_init(flex_button_evdev_t *evdev, flex_button_ctx_t *ctx,
+    const flex_button_evdev_key_t *keys, uint16_t key_num)
+{
+    uint8_t i;
+
+    if (!evdev || !ctx || !keys || (key_num == 0) || (key_num > FLEX_BTN_MAX_NUM))
+    {
+        return -1;
+    }
+
+    memset(evdev, 0, sizeof(*evdev));
+    evdev->ctx = ctx;
+    evdev->keys = keys;
+    evdev->key_num = key_num;
+    evdev->uinput_fd = -1;
+    for (i = 0; i < FLEX_BTN_EVDEV_MAX_FDS; i ++)
+    {
+        evdev->input_fd[i] = -1;
+    }
+
+    evdev->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (evdev->epoll_fd < 0)
+    {
+        return -1;
+    }
+
+    /* The context counts from 0, far from the signed overflow of its time */
+    evdev->base_ms = flex_button_evdev_clock_ms();
+
+    return 0;
+}
+
+/**
+ * flex_button_evdev_deinit
+ *
+ * @brief Close the input devices, the epoll and the uinput device.
+ *
+ * @param evdev: evdev backend
+ * @return none
+*/
+void flex_button_evdev_deinit(flex_button_evdev_t *evdev)
+{
+    uint8_t i;
+
+    for (i = 0; i < FLEX_BTN_EVDEV_MAX_FDS; i ++)
+    {
+        if (evdev->input_fd[i] >= 0)
+        {
+            close(evdev->input_fd[i]);
+            evdev->input_fd[i] = -1;
+        }
+    }
+
+    if (evdev->uinput_fd >= 0)
+    {
+        ioctl(evdev->uinput_fd, UI_DEV_DESTROY);
+        close(evdev->uinput_fd);
+        evdev->uinput_fd = -1;
+    }
+
+    if (evdev->epoll_fd >= 0)
+    {
+        close(evdev->epoll_fd);
+        evdev->epoll_fd = -1;
+    }
+}
+
+/**
+ * flex_button_evdev_add_fd
+ *
+ * @brief Read input events from 'fd', e.g. an evdev device opened by the
+ *        application. The backend owns the fd, it is closed on error and by
+ *        flex_button_evdev_deinit.
+ *
+ * @param evdev: evdev backend
+ * @param fd: file descriptor that reads struct input_event
+ * @return 0 on success, -1 on error
+*/
+int flex_button_evdev_add_fd(flex_button_evdev_t *evdev, int fd)
+{
+    struct epoll_event ev;
+    int clock_id = CLOCK_MONOTONIC;
+    int flags;
+    uint8_t i;
+
+    for (i = 0; i < FLEX_BTN_EVDEV_MAX_FDS; i ++)
+    {
+        if (evdev->input_fd[i] < 0)
+        {
+            break;
+        }
+    }
+
+    if ((fd < 0) || (i >= FLEX_BTN_EVDEV_MAX_FDS))
+    {
+        return -1;
+    }
+
+    flags = fcntl(fd, F_GETFL);
+    if ((flags < 0) || (fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0))
+    {
+        return -1;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = i;
+    if (epoll_ctl(evdev->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+        return -1;
+    }
+
+    /* Event time on the clock of the context, not on the wall clock */
+    evdev->input_clock[i] = (ioctl(fd, EVIOCSCLOCKID, &clock_id) == 0) ? 1 : 0;
+    evdev->input_fd[i] = fd;
+
+    return 0;
+}
+
+/**
+ * flex_button_evdev_open
+ *
+ * @brief Open an evdev device and read its key events.
+ *
+ * @param evdev: evdev backend
+ * @param path: device path, e.g. "/dev/input/event0"
+ * @param grab: 1 to take the device from the other readers, e.g. the console
+ * @return The fd of the device, -1 on error
+*/
+int flex_button_evdev_open(flex_button_evdev_t *evdev, const char *path, uint8_t grab)
+{
+    int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    if ((grab && (ioctl(fd, EVIOCGRAB, 1) < 0)) ||
+        (flex_button_evdev_add_fd(evdev, fd) < 0))
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * @brief Report the level of key k to the context, when it changes.
+ *
+ * @param evdev: evdev backend
+ * @param slot: the device slot that reports the level
+ * @param k: index in the key table
+ * @param level: 1 while the key is down
+ * @param timestamp: the time of the change, in milliseconds
+ * @return 1 when the level changed
+*/
+static uint8_t flex_button_evdev_level(flex_button_evdev_t *evdev, uint8_t slot,
+    uint16_t k, uint8_t level, uint32_t timestamp)
+{
+    btn_type_t *word = &evdev->level[EVDEV_WORD(k)];
+
+    evdev->key_slot[k] = slot;
+    if (((*word & EVDEV_BIT(k)) ? 1 : 0) == level)
+    {
+        return 0;
+    }
+
+    *word ^= EVDEV_BIT(k);
+    if (flex_button_ctx_notify_edge(evdev->ctx, evdev->keys[k].id, level, timestamp) > 0)
+    {
+        /* The edge queue is full, handle it before the next change */
+        flex_button_ctx_tickless_scan(evdev->ctx, flex_button_evdev_now(evdev));
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Read the levels of all keys again, after the kernel dropped events.
+ *
+ * @param evdev: evdev backend
+ * @param slot: the device slot
+ * @param timestamp: the time of the levels, in milliseconds
+ * @return none
+*/
+static void flex_button_evdev_resync(flex_button_evdev_t *evdev, uint8_t slot, uint32_t timestamp)
+{
+    int fd = evdev->input_fd[slot];
+    uint8_t supported[KEY_MAX / 8 + 1];
+    uint8_t down[KEY_MAX / 8 + 1];
+    uint16_t k;
+
+    memset(supported, 0, sizeof(supported));
+    memset(down, 0, sizeof(down));
+    if ((ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(supported)), supported) < 0) ||
+        (ioctl(fd, EVIOCGKEY(sizeof(down)), down) < 0))
+    {
+        return;
+    }
+
+    for (k = 0; k < evdev->key_num; k ++)
+    {
+        if ((evdev->keys[k].code <= KEY_MAX) && EVDEV_TEST_BIT(supported, evdev->keys[k].code))
+        {
+            flex_button_evdev_level(evdev, slot, k, EVDEV_TEST_BIT(down, evdev->keys[k].code), timestamp);
+        }
+    }
+}
+
+/**
+ * @brief Read all pending input events of a device.
+ *        The key changes of each input frame (up to SYN_REPORT) are processed
+ *        together at the time of the frame, so a click within one read is not lost.
+ *
+ * @param evdev: evdev backend
+ * @param slot: the device slot
+ * @return Number of key changes, -1 when the device is closed or failed
+*/
+static int flex_button_evdev_read(flex_button_evdev_t *evdev, uint8_t slot)
+{
+    struct input_event ev[FLEX_BTN_EVDEV_READ_BATCH];
+    int fd = evdev->input_fd[slot];
+    uint32_t timestamp = 0;
+    uint8_t changed = 0;
+    uint8_t dropped = 0;
+    int cnt = 0;
+    ssize_t len;
+    size_t n, i;
+    uint16_t k;
+
+    for (;;)
+    {
+        len = read(fd, ev, sizeof(ev));
+        if (len < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+            {
+                break;
+            }
+            return -1;
+        }
+        if (len == 0)
+        {
+            return -1; /* end of file */
+        }
+
+        n = (size_t)len / sizeof(ev[0]);
+        for (i = 0; i < n; i ++)
+        {
+            timestamp = evdev->input_clock[slot] ?
+                (uint32_t)((uint64_t)ev[i].input_event_sec * 1000 +
+                    (uint64_t)ev[i].input_event_usec / 1000 - evdev->base_ms) :
+                flex_button_evdev_now(evdev);
+
+            if ((ev[i].type == EV_KEY) && !dropped && (ev[i].value != 2)) /* 2 is autorepeat */
+            {
+                for (k = 0; k < evdev->key_num; k ++)
+                {
+                    if (evdev->keys[k].code == ev[i].code)
+                    {
+                        if (flex_button_evdev_level(evdev, slot, k, ev[i].value ? 1 : 0, timestamp))
+                        {
+                            changed = 1;
+                            cnt ++;
+                        }
+                        break;
+                    }
+                }
+            }
+            else if ((ev[i].type == EV_SYN) && (ev[i].code == SYN_DROPPED))
+            {
+                dropped = 1;
+            }
+            else if ((ev[i].type == EV_SYN) && (ev[i].code == SYN_REPORT))
+            {
+                if (dropped)
+                {
+                    dropped = 0;
+                    flex_button_evdev_resync(evdev, slot, timestamp);
+                    changed = 1;
+                }
+                if (changed)
+                {
+                    flex_button_ctx_tickless_scan(evdev->ctx, timestamp);
+                    changed = 0;
+                }
+            }
+        }
+
+        if ((size_t)len < sizeof(ev))
+        {
+            break; /* no more events */
+        }
+    }
+
+    /* Sources without SYN_REPORT, e.g. a pipe */
+    if (changed)
+    {
+        flex_button_ctx_tickless_scan(evdev->ctx, timestamp);
+    }
+
+    return cnt;
+}
+
+/**
+ * @brief Release the keys held on a device that is unplugged or closed,
+ *        so they do not stay pressed.
+ *
+ * @param evdev: evdev backend
+ * @param slot: the device slot
+ * @param timestamp: the time of the release, in milliseconds
+ * @return none
+*/
+static void flex_button_evdev_release(flex_button_evdev_t *evdev, uint8_t slot, uint32_t timestamp)
+{
+    uint8_t changed = 0;
+    uint16_t k;
+
+    for (k = 0; k < evdev->key_num; k ++)
+    {
+        if ((evdev->key_slot[k] == slot) && flex_button_evdev_level(evdev, slot, k, 0, timestamp))
+        {
+            changed = 1;
+        }
+    }
+
+    if (changed)
+    {
+        flex_button_ctx_tickless_scan(evdev->ctx, timestamp);
+    }
+}
+
+/**
+ * flex_button_evdev_poll
+ *
+ * @brief Wait for key events or the next button deadline, and process them.
+ *        Call it in a loop in the button thread, it replaces flex_button_scan.
+ *
+ * @param evdev: evdev backend
+ * @param timeout_ms: longest wait, -1 to wait until something happens
+ * @return Number of key changes, -1 on error
+*/
+int flex_button_evdev_poll(flex_button_evdev_t *evdev, int timeout_ms)
+{
+    struct epoll_event events[FLEX_BTN_EVDEV_MAX_FDS];
+    uint32_t now = flex_button_evdev_now(evdev);
+    uint32_t deadline;
+    int wait = FLEX_BTN_EVDEV_IDLE_MS;
+    int cnt = 0;
+    int n, i, ret;
+
+    if (flex_button_ctx_next_deadline(evdev->ctx, &deadline))
+    {
+        wait = ((int32_t)(deadline - now) > 0) ? (int32_t)(deadline - now) : 0;
+    }
+    if ((timeout_ms >= 0) && (timeout_ms < wait))
+    {
+        wait = timeout_ms;
+    }
+
+    n = epoll_wait(evdev->epoll_fd, events, FLEX_BTN_EVDEV_MAX_FDS, wait);
+    if (n < 0)
+    {
+        return (errno == EINTR) ? 0 : -1;
+    }
+
+    for (i = 0; i < n; i ++)
+    {
+        uint8_t slot = (uint8_t)events[i].data.u32;
+
+        if (evdev->input_fd[slot] < 0)
+        {
+            continue;
+        }
+
+        ret = flex_button_evdev_read(evdev, slot);
+        if (ret < 0)
+        {
+            /* Unplugged or closed, its keys are released */
+            flex_button_evdev_release(evdev, slot, flex_button_evdev_now(evdev));
+            epoll_ctl(evdev->epoll_fd, EPOLL_CTL_DEL, evdev->input_fd[slot], NULL);
+            close(evdev->input_fd[slot]);
+            evdev->input_fd[slot] = -1;
+            continue;
+        }
+        cnt += ret;
+    }
+
+    /* The expired deadlines */
+    flex_button_ctx_tickless_scan(evdev->ctx, flex_button_evdev_now(evdev));
+
+    return cnt;
+}
+
+/**
+ * flex_button_evdev_uinput_open
+ *
+ * @brief Create a uinput device that sends the gestures as key codes,
+ *        see flex_button_evdev_emit.
+ *
+ * @param evdev: evdev backend
+ * @param name: device name
+ * @param gestures: key code of each gesture, must stay valid
+ * @param gesture_num: number of gestures
+ * @return 0 on success, -1 on error
+*/
+int flex_button_evdev_uinput_open(flex_button_evdev_t *evdev, const char *name,
+    const flex_button_evdev_gesture_t *gestures, uint16_t gesture_num)
+{
+    struct uinput_setup setup;
+    uint16_t g;
+    int fd;
+
+    if (!gestures || (gesture_num == 0) || (evdev->uinput_fd >= 0))
+    {
+        return -1;
+    }
+
+    fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    if (ioctl(fd, UI_SET_EVBIT, EV_KEY) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    for (g = 0; g < gesture_num; g ++)
+    {
+        if (ioctl(fd, UI_SET_KEYBIT, gestures[g].code) < 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+
+    memset(&setup, 0, sizeof(setup));
+    setup.id.bustype = BUS_VIRTUAL;
+    strncpy(setup.name, name, UINPUT_MAX_NAME_SIZE - 1);
+
+    if ((ioctl(fd, UI_DEV_SETUP, &setup) < 0) || (ioctl(fd, UI_DEV_CREATE) < 0))
+    {
+        close(fd);
+        return -1;
+    }
+
+    evdev->gestures = gestures;
+    evdev->gesture_num = gesture_num;
+    evdev->uinput_fd = fd;
+
+    return 0;
+}
+
+/**
+ * flex_button_evdev_emit
+ *
+ * @brief Send the key codes of a button event to the uinput device, each as
+ *        a press and a release. Call it from the button callback, or for
+ *        the events taken from the event queue.
+ *
+ * @param evdev: evdev backend
+ * @param id: button id, or combination or encoder id
+ * @param event: the button event
+ * @return Number of key codes sent, -1 on error
+*/
+int flex_button_evdev_emit(flex_button_evdev_t *evdev, uint8_t id, uint8_t event)
+{
+    struct input_event ev[4];
+    uint16_t g;
+    int cnt = 0;
+
+    if (evdev->uinput_fd < 0)
+    {
+        return -1;
+    }
+
+    for (g = 0; g < evdev->gesture_num; g ++)
+    {
+        if ((evdev->gestures[g].id != id) || (evdev->gestures[g].event != event))
+        {
+            continue;
+        }
+
+        /* Press and release in one write, the kernel sets the time */
+        memset(ev, 0, sizeof(ev));
+        ev[0].type = EV_KEY;
+        ev[0].code = evdev->gestures[g].code;
+        ev[0].value = 1;
+        ev[1].type = EV_SYN;
+        ev[1].code = SYN_REPORT;
+        ev[2].type = EV_KEY;
+        ev[2].code = evdev->gestures[g].code;
+        ev[2].value = 0;
+        ev[3].type = EV_SYN;
+        ev[3].code = SYN_REPORT;
+
+        if (write(evdev->uinput_fd, ev, sizeof(ev)) != (ssize_t)sizeof(ev))
+        {
+            return -1;
+        }
+        cnt ++;
+    }
+
+    return cnt;
+}
@@ -0,0 +1,170 @@
+/**
+ * @File:    flexible_button_evdev.h
+ * @Author:  agent
+ * @Date:    2026-10-17
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * message:
+ * Linux backend, the keys come from evdev devices (/dev/input/event*).
+ * The input events are read in batches with epoll, the key codes are mapped
+ * to the registered buttons and reported with flex_button_notify_edge, and
+ * the buttons are processed only when input arrives or a deadline expires.
+ * The gestures can be sent again as key codes of a uinput device.
+ * Requires FLEX_BTN_USING_TICKLESS.
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#ifndef __FLEXIBLE_BUTTON_EVDEV_H__
+#define __FLEXIBLE_BUTTON_EVDEV_H__
+
+#include "flexible_button.h"
+
+#ifndef FLEX_BTN_USING_TICKLESS
+#error "flexible_button_evdev requires FLEX_BTN_USING_TICKLESS"
+#endif
+
+/* Input events read from a device at once */
+#ifndef FLEX_BTN_EVDEV_READ_BATCH
+#define FLEX_BTN_EVDEV_READ_BATCH 64
+#endif
+
+/* Input devices of a backend */
+#ifndef FLEX_BTN_EVDEV_MAX_FDS
+#define FLEX_BTN_EVDEV_MAX_FDS 8
+#endif
+
+/* Longest sleep while no button is active, keeps the tickless time base in range */
+#ifndef FLEX_BTN_EVDEV_IDLE_MS
+#define FLEX_BTN_EVDEV_IDLE_MS (3600 * 1000)
+#endif
+
+/**
+ * flex_button_evdev_key_t
+ *
+ * @brief Maps a key code to a registered button.
+ *        The button must be registered with 'pressed_logic_level' 1,
+ *        its level is 1 while the key is down.
+ *
+ * @member code
+ *         Key code of the input events, e.g. KEY_ENTER.
+ *
+ * @member id
+ *         The button id.
+*/
+typedef struct flex_button_evdev_key
+{
+    uint16_t code;
+    uint8_t id;
+} flex_button_evdev_key_t;
+
+/**
+ * flex_button_evdev_gesture_t
+ *
+ * @brief Key code sent to the uinput device for a button event.
+ *
+ * @member id
+ *         The button id, or the combination or encoder id.
+ *
+ * @member event
+ *         The button event, flex_button_event_t.
+ *
+ * @member code
+ *         Key code to press and release, e.g. KEY_POWER for a long press.
+*/
+typedef struct flex_button_evdev_gesture
+{
+    uint8_t id;
+    uint8_t event;
+    uint16_t code;
+} flex_button_evdev_gesture_t;
+
+/**
+ * flex_button_evdev_t
+ *
+ * @brief evdev backend, all members are internal use.
+ *
+ * @member ctx
+ *         The context of the buttons.
+ *
+ * @member keys, key_num
+ *         Key code of each button.
+ *
+ * @member level
+ *         Level of each key reported to the context, bit k is keys[k].
+ *
+ * @member key_slot
+ *         The device slot that reported the level of each key, its pressed
+ *         keys are released when the device is unplugged.
+ *
+ * @member gestures, gesture_num
+ *         Key codes sent to the uinput device.
+ *
+ * @member epoll_fd, uinput_fd
+ *         The epoll of the input devices, and the uinput device, -1 when not opened.
+ *
+ * @member input_fd, input_clock
+ *         The input devices, -1 for a free slot, and 1 when the time of their
+ *         events is CLOCK_MONOTONIC, otherwise the events take the read time.
+ *
+ * @member base_ms
+ *         CLOCK_MONOTONIC time of flex_button_evdev_init, the time of the
+ *         context is counted from here.
+*/
+typedef struct flex_button_evdev
+{
+    flex_button_ctx_t *ctx;
+
+    const flex_button_evdev_key_t *keys;
+    uint16_t key_num;
+    btn_type_t level[FLEX_BTN_STATUS_WORDS];
+    uint8_t key_slot[FLEX_BTN_MAX_NUM];
+
+    const flex_button_evdev_gesture_t *gestures;
+    uint16_t gesture_num;
+
+    int epoll_fd;
+    int uinput_fd;
+    int input_fd[FLEX_BTN_EVDEV_MAX_FDS];
+    uint8_t input_clock[FLEX_BTN_EVDEV_MAX_FDS];
+
+    uint64_t base_ms;
+} flex_button_evdev_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int flex_button_evdev_init(flex_button_evdev_t *evdev, flex_button_ctx_t *ctx,
+    const flex_button_evdev_key_t *keys, uint16_t key_num);
+void flex_button_evdev_deinit(flex_button_evdev_t *evdev);
+int flex_button_evdev_open(flex_button_evdev_t *evdev, const char *path, uint8_t grab);
+int flex_button_evdev_add_fd(flex_button_evdev_t *evdev, int fd);
+int flex_button_evdev_poll(flex_button_evdev_t *evdev, int timeout_ms);
+uint32_t flex_button_evdev_now(flex_button_evdev_t *evdev);
+
+int flex_button_evdev_uinput_open(flex_button_evdev_t *evdev, const char *name,
+    const flex_button_evdev_gesture_t *gestures, uint16_t gesture_num);
+int flex_button_evdev_emit(flex_button_evdev_t *evdev, uint8_t id, uint8_t event);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __FLEXIBLE_BUTTON_EVDEV_H__ */
@@ -0,0 +1,452 @@
+/**
+ * @File:    flex_button_bench.c
+ * @Author:  agent
+ * @Date:    2026-10-17
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * message:
+ * Host benchmark of the button scan, runs on Linux without hardware.
+ * Simulated buttons are driven by synthetic traces, and the cost of each
+ * flex_button_scan call is reported. With FLEX_BTN_USING_TICKLESS the level
+ * changes are reported with flex_button_notify_edge, flex_button_tickless_scan
+ * runs only when needed, and the cost is per scan period.
+ * The events are counted from the callbacks, the event queue or the batch
+ * handler, as the options select.
+ *
+ * Build, in the tools directory, with the same options as the firmware:
+ *     gcc -O2 -I.. flex_button_bench.c ../flexible_button.c -o flex_button_bench
+ *     gcc -O2 -I.. -DFLEX_BTN_STATUS_WORDS=4 flex_button_bench.c ../flexible_button.c -o flex_button_bench
+ *     gcc -O2 -I.. -DFLEX_BTN_USING_TICKLESS flex_button_bench.c ../flexible_button.c -o flex_button_bench
+ *
+ * Usage:
+ *     ./flex_button_bench [scans] [buttons]
+ *     scans:   scans per test, default 200000
+ *     buttons: only test this number of buttons, default 1, 8, 16, 32 ... FLEX_BTN_MAX_NUM
+ *
+ * Traces:
+ *     idle:    all buttons released
+ *     one:     one button pressed and released, short and long presses
+ *     all:     all buttons pressed and released, same as 'one' with different phases
+ *     bounce:  same as 'all' with contact bounce, the level toggles randomly
+ *              each millisecond for BENCH_BOUNCE_MS after each press and
+ *              release. The periodic scan samples a burst once at most, so
+ *              the bounce mostly delays the edges, while the tickless build
+ *              is notified of every toggle.
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "flexible_button.h"
+
+#define SCAN_PERIOD_MS (1000 / FLEX_BTN_SCAN_FREQ_HZ)
+
+/* Contact bounce after each level change of the 'bounce' trace */
+#define BENCH_BOUNCE_MS 10
+
+typedef enum
+{
+    TRACE_IDLE = 0,
+    TRACE_ONE,
+    TRACE_ALL,
+    TRACE_BOUNCE,
+    TRACE_MAX
+} trace_t;
+
+static const char *trace_name[TRACE_MAX] = { "idle", "one", "all", "bounce" };
+
+static flex_button_ctx_t bench_ctx;
+static flex_button_t buttons[FLEX_BTN_MAX_NUM];
+
+/* Button levels of all scans, FLEX_BTN_STATUS_WORDS words per scan */
+static btn_type_t *trace_levels;
+static const btn_type_t *curr_levels;
+static unsigned long event_cnt;
+
+#ifdef FLEX_BTN_USING_TICKLESS
+typedef struct
+{
+    uint32_t timestamp;
+    uint8_t id;
+    uint8_t level;
+} bench_edge_t;
+
+/* Level changes of all scan periods, from edge_first[s] to edge_first[s + 1] */
+static bench_edge_t *trace_edges;
+static uint32_t *edge_first;
+static uint32_t edge_num;
+static uint32_t edge_size;
+
+static void bench_edge_add(uint32_t i, uint8_t level, uint32_t timestamp)
+{
+    if (edge_num >= edge_size)
+    {
+        edge_size = edge_size ? edge_size * 2 : 4096;
+        trace_edges = realloc(trace_edges, edge_size * sizeof(bench_edge_t));
+        if (!trace_edges)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+
+    trace_edges[edge_num].timestamp = timestamp;
+    trace_edges[edge_num].id = (uint8_t)i;
+    trace_edges[edge_num].level = level;
+    edge_num ++;
+}
+#endif
+
+static uint8_t bench_button_read(void *arg)
+{
+    uint32_t i = (uint32_t)((flex_button_t *)arg - buttons);
+
+    return (uint8_t)((curr_levels[i / FLEX_BTN_WORD_BITS] >> (i % FLEX_BTN_WORD_BITS)) & 1);
+}
+
+static void bench_button_evt_cb(void *arg)
+{
+    (void)arg;
+    event_cnt ++;
+}
+
+#ifdef FLEX_BTN_USING_EVENT_BATCH
+static void bench_batch_handler(void *arg, const flex_button_batch_event_t *events, uint16_t num)
+{
+    (void)arg;
+    (void)events;
+    event_cnt += num;
+}
+#endif
+
+/**
+ * @brief Pressing state of a button in the 'one', 'all' and 'bounce' traces.
+ *        Cycles through clicks, a short press and a long hold.
+ *
+ * @param t: time, in milliseconds
+ * @param since: time since the last press or release, in milliseconds
+ * @return 1 when pressed
+*/
+static uint8_t bench_pattern(uint32_t t, uint32_t *since)
+{
+    static const uint16_t press_ms[] = { 60, 100, 80, 2000, 120, 5000 };
+    static const uint16_t release_ms[] = { 100, 600, 120, 400, 800, 1000 };
+    uint32_t period = 0;
+    uint8_t k;
+
+    for (k = 0; k < sizeof(press_ms) / sizeof(press_ms[0]); k ++)
+    {
+        period += press_ms[k] + release_ms[k];
+    }
+
+    t %= period;
+    for (k = 0; k < sizeof(press_ms) / sizeof(press_ms[0]); k ++)
+    {
+        *since = t;
+        if (t < press_ms[k])
+        {
+            return 1;
+        }
+        t -= press_ms[k];
+        *since = t;
+        if (t < release_ms[k])
+        {
+            return 0;
+        }
+        t -= release_ms[k];
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Pressing state of a button of a trace at the specified time.
+ *
+ * @param trace: trace
+ * @param i: button index
+ * @param t: time, in milliseconds
+ * @return 1 when pressed
+*/
+static uint8_t bench_level(trace_t trace, uint32_t i, uint32_t t)
+{
+    uint32_t since;
+    uint32_t rnd;
+    uint8_t pressed;
+
+    switch (trace)
+    {
+    case TRACE_ONE:
+        return (i == 0) ? bench_pattern(t, &since) : 0;
+    case TRACE_ALL:
+        return bench_pattern(t + i * 7 * SCAN_PERIOD_MS, &since);
+    case TRACE_BOUNCE:
+        /* Phases not aligned to the scans, so the scans sample the bounce */
+        pressed = bench_pattern(t + i * 37, &since);
+        if (since < BENCH_BOUNCE_MS)
+        {
+            /* Random level each millisecond, the same for every call */
+            rnd = t ^ (i << 24);
+            rnd ^= rnd >> 16;
+            rnd *= 0x7FEB352Du;
+            rnd ^= rnd >> 15;
+            rnd *= 0x846CA68Bu;
+            rnd ^= rnd >> 16;
+            pressed = rnd & 1;
+        }
+        return pressed;
+    default:
+        return 0;
+    }
+}
+
+static void bench_trace_build(trace_t trace, uint32_t num, uint32_t scans)
+{
+    uint32_t s, i;
+#ifdef FLEX_BTN_USING_TICKLESS
+    uint32_t t;
+    uint8_t prev[FLEX_BTN_MAX_NUM];
+
+    edge_num = 0;
+#endif
+
+    for (s = 0; s < scans; s ++)
+    {
+        btn_type_t *levels = &trace_levels[s * FLEX_BTN_STATUS_WORDS];
+
+#ifdef FLEX_BTN_USING_TICKLESS
+        edge_first[s] = edge_num;
+#endif
+        for (i = 0; i < num; i ++)
+        {
+            /* pressed_logic_level is 0, pressed buttons read 0 */
+            uint8_t level = !bench_level(trace, i, s * SCAN_PERIOD_MS);
+
+            if (level)
+            {
+                levels[i / FLEX_BTN_WORD_BITS] |= (btn_type_t)1 << (i % FLEX_BTN_WORD_BITS);
+            }
+            else
+            {
+                levels[i / FLEX_BTN_WORD_BITS] &= ~((btn_type_t)1 << (i % FLEX_BTN_WORD_BITS));
+            }
+
+#ifdef FLEX_BTN_USING_TICKLESS
+            /* Every level change of the scan period, with the bounce */
+            if (s == 0)
+            {
+                bench_edge_add(i, level, 0);
+                prev[i] = level;
+                continue;
+            }
+            for (t = (s - 1) * SCAN_PERIOD_MS + 1; t <= s * SCAN_PERIOD_MS; t ++)
+            {
+                uint8_t l = (t == s * SCAN_PERIOD_MS) ? level : !bench_level(trace, i, t);
+
+                if (l != prev[i])
+                {
+                    bench_edge_add(i, l, t);
+                    prev[i] = l;
+                }
+            }
+#endif
+        }
+    }
+#ifdef FLEX_BTN_USING_TICKLESS
+    edge_first[scans] = edge_num;
+#endif
+}
+
+static void bench_buttons_init(uint32_t num)
+{
+    uint32_t i;
+
+    flex_button_ctx_init(&bench_ctx);
+#ifdef FLEX_BTN_USING_ARRAY_STORAGE
+    flex_button_ctx_array_init(&bench_ctx, buttons, (uint16_t)num);
+#endif
+
+    for (i = 0; i < num; i ++)
+    {
+        buttons[i] = (flex_button_t){ 0 };
+        buttons[i].id = (uint8_t)i;
+        buttons[i].usr_button_read = bench_button_read;
+        buttons[i].cb = bench_button_evt_cb;
+        buttons[i].pressed_logic_level = 0;
+        buttons[i].short_press_start_tick = FLEX_MS_TO_SCAN_CNT(1500);
+        buttons[i].long_press_start_tick = FLEX_MS_TO_SCAN_CNT(3000);
+        buttons[i].long_hold_start_tick = FLEX_MS_TO_SCAN_CNT(4500);
+        buttons[i].debounce_tick = 2;
+        flex_button_ctx_register(&bench_ctx, &buttons[i]);
+    }
+#ifdef FLEX_BTN_USING_EVENT_BATCH
+    flex_button_ctx_batch_handler(&bench_ctx, bench_batch_handler, NULL);
+#endif
+}
+
+static double bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+#ifdef FLEX_BTN_USING_TICKLESS
+/**
+ * @brief Report the level changes of a scan period, as the GPIO interrupt
+ *        does, and run the tickless scan when a level changed or a deadline
+ *        expired.
+*/
+static void bench_tickless(uint32_t s)
+{
+    uint32_t now = s * SCAN_PERIOD_MS;
+    uint32_t deadline;
+    uint32_t k;
+
+    for (k = edge_first[s]; k < edge_first[s + 1]; k ++)
+    {
+        if (flex_button_ctx_notify_edge(&bench_ctx, trace_edges[k].id,
+            trace_edges[k].level, trace_edges[k].timestamp) > 0)
+        {
+            flex_button_ctx_tickless_scan(&bench_ctx, trace_edges[k].timestamp);
+        }
+    }
+
+    if ((edge_first[s + 1] > edge_first[s]) ||
+        (flex_button_ctx_next_deadline(&bench_ctx, &deadline) && ((int32_t)(deadline - now) <= 0)))
+    {
+        flex_button_ctx_tickless_scan(&bench_ctx, now);
+    }
+}
+#endif
+
+static void bench_run(trace_t trace, uint32_t num, uint32_t scans)
+{
+    uint32_t s;
+    double start, ns;
+
+    bench_trace_build(trace, num, scans);
+    bench_buttons_init(num);
+    event_cnt = 0;
+
+    start = bench_now_ns();
+    for (s = 0; s < scans; s ++)
+    {
+        curr_levels = &trace_levels[s * FLEX_BTN_STATUS_WORDS];
+#if defined(FLEX_BTN_USING_TICKLESS)
+        bench_tickless(s);
+#elif defined(FLEX_BTN_USING_TIMESTAMP)
+        flex_button_ctx_scan(&bench_ctx, s * SCAN_PERIOD_MS);
+#else
+        flex_button_ctx_scan(&bench_ctx);
+#endif
+#ifdef FLEX_BTN_USING_EVENT_QUEUE
+        {
+            flex_button_event_record_t record;
+
+            while (flex_button_ctx_event_pop(&bench_ctx, &record))
+            {
+                event_cnt ++;
+            }
+        }
+#endif
+    }
+    ns = bench_now_ns() - start;
+
+    printf("%-8s %8lu %12.1f %12.2f %10.4f\n",
+        trace_name[trace],
+        (unsigned long)num,
+        ns / scans,
+        ns / scans / num,
+        (double)event_cnt / scans);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t scans = 200000;
+    uint32_t only = 0;
+    uint32_t num;
+    int trace;
+
+    if (argc > 1)
+    {
+        scans = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2)
+    {
+        only = (uint32_t)strtoul(argv[2], NULL, 0);
+        if ((only < 1) || (only > FLEX_BTN_MAX_NUM))
+        {
+            fprintf(stderr, "buttons must be 1 - %u\n", (unsigned)FLEX_BTN_MAX_NUM);
+            return 1;
+        }
+    }
+    if (scans < 1)
+    {
+        scans = 1;
+    }
+
+    trace_levels = calloc((size_t)scans * FLEX_BTN_STATUS_WORDS, sizeof(btn_type_t));
+#ifdef FLEX_BTN_USING_TICKLESS
+    edge_first = calloc((size_t)scans + 1, sizeof(uint32_t));
+    if (!edge_first)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+#endif
+    if (!trace_levels)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printf("%u scans per test, FLEX_BTN_MAX_NUM %u\n", (unsigned)scans, (unsigned)FLEX_BTN_MAX_NUM);
+    printf("%-8s %8s %12s %12s %10s\n", "trace", "buttons", "ns/scan", "ns/button", "event/scan");
+
+    for (trace = 0; trace < TRACE_MAX; trace ++)
+    {
+        if (only)
+        {
+            bench_run((trace_t)trace, only, scans);
+            continue;
+        }
+
+        bench_run((trace_t)trace, 1, scans);
+        for (num = 8; num < FLEX_BTN_MAX_NUM; num *= 2)
+        {
+            bench_run((trace_t)trace, num, scans);
+        }
+        bench_run((trace_t)trace, FLEX_BTN_MAX_NUM, scans);
+    }
+
+    free(trace_levels);
+#ifdef FLEX_BTN_USING_TICKLESS
+    free(edge_first);
+    free(trace_edges);
+#endif
+
+    return 0;
+}
@@ -0,0 +1,302 @@
+/**
+ * @File:    flex_button_compact_check.c
+ * @Author:  agent
+ * @Date:    2026-10-17
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * message:
+ * Host check of the compact scan against flex_button_scan.
+ * The same random press traces, short clicks, multiple clicks and holds
+ * past the 8-bit scan count, are scanned by the core and by the compact
+ * key set with the same timing, and the events must be the same. The scan
+ * of each event may differ by the prescale rounding,
+ * 2^FLEX_BTN_COMPACT_PRESCALE_SHIFT - 1 scans, and the click count is
+ * compared up to 255, the limit of the compact state.
+ *
+ * Build, in the tools directory, with the same options as the firmware:
+ *     gcc -O2 -I.. flex_button_compact_check.c ../flexible_button.c \
+ *         ../flexible_button_compact.c -o flex_button_compact_check
+ *
+ * Usage:
+ *     ./flex_button_compact_check [seed [scans]]
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flexible_button.h"
+#include "flexible_button_compact.h"
+
+#if defined(FLEX_BTN_USING_EVENT_QUEUE) || defined(FLEX_BTN_USING_EVENT_BATCH)
+#error "The check reads the events in the button callback"
+#endif
+#ifdef FLEX_BTN_USING_DEBOUNCE
+#error "The compact scan does not debounce"
+#endif
+
+#define CHECK_KEY_NUM      24
+#define CHECK_PROFILE_NUM  4
+
+/* Scan count difference allowed by the prescaler */
+#define CHECK_SCAN_TOLERANCE ((1 << FLEX_BTN_COMPACT_PRESCALE_SHIFT) - 1)
+
+typedef struct
+{
+    uint32_t scan;
+    uint8_t id;
+    uint8_t event;
+    uint16_t click_cnt;
+} check_event_t;
+
+typedef struct
+{
+    check_event_t *events;
+    uint32_t event_num;
+    uint32_t event_size;
+} check_log_t;
+
+/* Timing of the keys, up to the saturated scan count of the compact state */
+static const flex_button_compact_profile_t check_profiles[CHECK_PROFILE_NUM] =
+{
+    { 20, 60, 120, MAX_MULTIPLE_CLICKS_INTERVAL },
+    { 15, FLEX_BTN_COMPACT_CNT_MAX / 4, FLEX_BTN_COMPACT_CNT_MAX / 2, 10 },
+    { 3, FLEX_BTN_COMPACT_CNT_MAX / 4 + 2, FLEX_BTN_COMPACT_CNT_MAX * 3 / 5, 30 },
+    { 40, FLEX_BTN_COMPACT_CNT_MAX / 2, FLEX_BTN_COMPACT_CNT_MAX - 1, 5 },
+};
+
+static uint8_t levels[CHECK_KEY_NUM];
+static uint32_t scan;
+
+static flex_button_ctx_t core_ctx;
+static flex_button_t core_buttons[CHECK_KEY_NUM];
+static check_log_t core_log;
+
+static flex_button_compact_key_t compact_keys[CHECK_KEY_NUM];
+static flex_button_compact_state_t compact_state[CHECK_KEY_NUM];
+static flex_button_compact_t compact;
+static check_log_t compact_log;
+
+static void check_event_add(check_log_t *log, uint8_t id, uint8_t event, uint16_t click_cnt)
+{
+    if (log->event_num >= log->event_size)
+    {
+        log->event_size = log->event_size ? log->event_size * 2 : 1024;
+        log->events = realloc(log->events, log->event_size * sizeof(check_event_t));
+        if (!log->events)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+
+    log->events[log->event_num].scan = scan;
+    log->events[log->event_num].id = id;
+    log->events[log->event_num].event = event;
+    log->events[log->event_num].click_cnt = click_cnt > 0xFF ? 0xFF : click_cnt;
+    log->event_num ++;
+}
+
+static uint8_t check_core_read(void *arg)
+{
+    return levels[((flex_button_t *)arg)->id];
+}
+
+static void check_core_cb(void *arg)
+{
+    flex_button_t *btn = (flex_button_t *)arg;
+
+    check_event_add(&core_log, btn->id, btn->event, btn->click_cnt);
+}
+
+static uint8_t check_compact_read(btn_index_t index)
+{
+    return levels[index];
+}
+
+static void check_compact_cb(btn_index_t index, flex_button_event_t event, uint16_t click_cnt)
+{
+    check_event_add(&compact_log, (uint8_t)index, (uint8_t)event, click_cnt);
+}
+
+static const flex_button_compact_handler_t check_handlers[1] =
+{
+    { check_compact_read, check_compact_cb },
+};
+
+static const flex_button_compact_config_t check_config =
+{
+    compact_keys, check_profiles, check_handlers, compact_state,
+    CHECK_KEY_NUM, CHECK_PROFILE_NUM, 1,
+};
+
+static int check_init(void)
+{
+    const flex_button_compact_profile_t *profile;
+    uint32_t i;
+
+    flex_button_ctx_init(&core_ctx);
+#ifdef FLEX_BTN_USING_ARRAY_STORAGE
+    flex_button_ctx_array_init(&core_ctx, core_buttons, CHECK_KEY_NUM);
+#endif
+
+    for (i = 0; i < CHECK_KEY_NUM; i ++)
+    {
+        profile = &check_profiles[i % CHECK_PROFILE_NUM];
+
+        compact_keys[i].profile = i % CHECK_PROFILE_NUM;
+        compact_keys[i].handler = 0;
+        compact_keys[i].pressed_logic_level = (i / CHECK_PROFILE_NUM) & 1;
+
+        memset(&core_buttons[i], 0, sizeof(flex_button_t));
+        core_buttons[i].id = (uint8_t)i;
+        core_buttons[i].usr_button_read = check_core_read;
+        core_buttons[i].cb = check_core_cb;
+        core_buttons[i].pressed_logic_level = compact_keys[i].pressed_logic_level;
+        core_buttons[i].short_press_start_tick = profile->short_press_start_tick;
+        core_buttons[i].long_press_start_tick = profile->long_press_start_tick;
+        core_buttons[i].long_hold_start_tick = profile->long_hold_start_tick;
+        if (flex_button_ctx_register(&core_ctx, &core_buttons[i]) < 0)
+        {
+            fprintf(stderr, "core register failed\n");
+            return 1;
+        }
+        core_buttons[i].max_multiple_clicks_interval = profile->max_multiple_clicks_interval;
+
+        levels[i] = !compact_keys[i].pressed_logic_level;
+    }
+
+    if (flex_button_compact_init(&compact, &check_config) < 0)
+    {
+        fprintf(stderr, "compact init failed\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Scans until the next level change of a key, clicks, presses
+ *        around the timing thresholds and holds past the 8-bit scan count.
+*/
+static uint16_t check_hold(uint8_t pressed)
+{
+    int r = rand() % 16;
+
+    if (!pressed)
+    {
+        return (r < 8) ? rand() % 20 : (uint16_t)(20 + rand() % 400);
+    }
+    if (r < 7)
+    {
+        return rand() % 10;
+    }
+    if (r < 13)
+    {
+        return rand() % 700;
+    }
+
+    return (uint16_t)(700 + rand() % 2000);
+}
+
+static int check_compare(void)
+{
+    const check_event_t *a;
+    const check_event_t *b;
+    uint32_t i;
+    uint32_t diff;
+
+    if (core_log.event_num != compact_log.event_num)
+    {
+        fprintf(stderr, "%lu core events, %lu compact events\n",
+            (unsigned long)core_log.event_num, (unsigned long)compact_log.event_num);
+    }
+
+    for (i = 0; (i < core_log.event_num) && (i < compact_log.event_num); i ++)
+    {
+        a = &core_log.events[i];
+        b = &compact_log.events[i];
+        diff = (a->scan > b->scan) ? a->scan - b->scan : b->scan - a->scan;
+
+        if ((a->id != b->id) || (a->event != b->event) ||
+            (a->click_cnt != b->click_cnt) || (diff > CHECK_SCAN_TOLERANCE))
+        {
+            fprintf(stderr, "event %lu: core scan %lu id %u event %u click %u, "
+                "compact scan %lu id %u event %u click %u\n", (unsigned long)i,
+                (unsigned long)a->scan, a->id, a->event, a->click_cnt,
+                (unsigned long)b->scan, b->id, b->event, b->click_cnt);
+            return 1;
+        }
+    }
+
+    return core_log.event_num != compact_log.event_num;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t seed = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 1;
+    uint32_t scans = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 200000;
+    uint16_t hold[CHECK_KEY_NUM] = { 0 };
+    uint8_t core_active;
+    uint8_t compact_active;
+    uint32_t i;
+
+    srand(seed);
+    if (check_init())
+    {
+        return 1;
+    }
+
+    for (scan = 1; scan <= scans; scan ++)
+    {
+        for (i = 0; i < CHECK_KEY_NUM; i ++)
+        {
+            if (hold[i])
+            {
+                hold[i] --;
+                continue;
+            }
+            levels[i] ^= 1;
+            hold[i] = check_hold(levels[i] == compact_keys[i].pressed_logic_level);
+        }
+
+        core_active = flex_button_ctx_scan(&core_ctx);
+        compact_active = flex_button_compact_scan(&compact);
+
+        if (core_active != compact_active)
+        {
+            fprintf(stderr, "scan %lu: %u core active buttons, %u compact\n",
+                (unsigned long)scan, core_active, compact_active);
+            return 1;
+        }
+    }
+
+    if (check_compare())
+    {
+        return 1;
+    }
+
+    printf("%lu scans, %lu events, same events\n",
+        (unsigned long)scans, (unsigned long)core_log.event_num);
+
+    return 0;
+}
@@ -0,0 +1,255 @@
+/**
+ * @File:    flex_button_hpp_check.cpp
+ * @Author:  agent
+ * @Date:    2026-10-17
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * message:
+ * Host check of flexible_button.hpp, runs on Linux without hardware.
+ * The same random button traces are scanned with the C API and with
+ * FlexButtons, the event streams must be identical. The cost of each
+ * scan of both is reported.
+ *
+ * Build, in the tools directory, without optional features:
+ *     gcc -O2 -I.. -c ../flexible_button.c -o flexible_button.o
+ *     g++ -O2 -I.. flex_button_hpp_check.cpp flexible_button.o -o flex_button_hpp_check
+ *
+ * Usage:
+ *     ./flex_button_hpp_check [scans]
+ *     scans: scans per test, default 200000
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "flexible_button.hpp"
+
+#define CHECK_BUTTON_NUM 8
+
+/* Button levels of all scans, bit i is button i */
+static uint32_t *trace_levels;
+static uint32_t curr_levels;
+
+/* Events of both scans, packed as scan << 32 | id << 24 | event << 16 | click_cnt */
+static uint64_t *log_c, *log_cpp;
+static uint32_t log_c_num, log_cpp_num, log_max;
+static uint32_t curr_scan;
+
+static flex_button_ctx_t check_ctx;
+static flex_button_t buttons[CHECK_BUTTON_NUM];
+
+static void check_log(uint64_t *log, uint32_t *num, uint8_t id, uint8_t event, uint16_t click_cnt)
+{
+    if (*num < log_max)
+    {
+        log[*num] = ((uint64_t)curr_scan << 32) | ((uint32_t)id << 24) | ((uint32_t)event << 16) | click_cnt;
+    }
+    (*num) ++;
+}
+
+static uint8_t check_button_read(void *arg)
+{
+    uint32_t i = (uint32_t)((flex_button_t *)arg - buttons);
+
+    return (uint8_t)((curr_levels >> i) & 1);
+}
+
+static void check_button_evt_cb(void *arg)
+{
+    flex_button_t *btn = (flex_button_t *)arg;
+
+    check_log(log_c, &log_c_num, btn->id, btn->event, btn->click_cnt);
+}
+
+struct CheckReader
+{
+    static uint8_t read(uint8_t index)
+    {
+        return (uint8_t)((curr_levels >> index) & 1);
+    }
+};
+
+struct CheckHandler
+{
+    static void on_event(uint8_t index, flex_button_event_t event, uint16_t click_cnt)
+    {
+        check_log(log_cpp, &log_cpp_num, index, (uint8_t)event, click_cnt);
+    }
+};
+
+struct CheckConfig : FlexButtonConfig
+{
+    typedef CheckReader Reader;
+    typedef CheckHandler Handler;
+};
+
+static void check_trace_build(uint32_t scans, uint32_t seed)
+{
+    uint32_t rnd = seed;
+    uint32_t hold[CHECK_BUTTON_NUM] = { 0 };
+    uint32_t levels = 0xFFFFFFFF;
+    uint32_t s, i;
+
+    /* Presses and releases of random length, from one scan to a long hold */
+    for (s = 0; s < scans; s ++)
+    {
+        for (i = 0; i < CHECK_BUTTON_NUM; i ++)
+        {
+            if (hold[i] == 0)
+            {
+                rnd = rnd * 1103515245 + 12345;
+                levels ^= (uint32_t)1 << i;
+                hold[i] = 1 + ((rnd >> 16) % ((rnd >> 30) == 0 ? 400 : 30));
+            }
+            hold[i] --;
+        }
+        trace_levels[s] = levels;
+    }
+}
+
+static void check_buttons_init(void)
+{
+    uint32_t i;
+
+    flex_button_ctx_init(&check_ctx);
+
+    for (i = 0; i < CHECK_BUTTON_NUM; i ++)
+    {
+        memset(&buttons[i], 0, sizeof(buttons[i]));
+        buttons[i].id = (uint8_t)i;
+        buttons[i].usr_button_read = check_button_read;
+        buttons[i].cb = check_button_evt_cb;
+        buttons[i].pressed_logic_level = 0;
+        buttons[i].short_press_start_tick = FLEX_MS_TO_SCAN_CNT(1500);
+        buttons[i].long_press_start_tick = FLEX_MS_TO_SCAN_CNT(3000);
+        buttons[i].long_hold_start_tick = FLEX_MS_TO_SCAN_CNT(4500);
+        buttons[i].max_multiple_clicks_interval = FLEX_MS_TO_SCAN_CNT(300);
+        flex_button_ctx_register(&check_ctx, &buttons[i]);
+    }
+}
+
+static double check_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int check_run(uint32_t scans, uint32_t seed, double *ns_c, double *ns_cpp)
+{
+    static FlexButtons<CHECK_BUTTON_NUM, CheckConfig> keys;
+    double start;
+    uint32_t i;
+
+    check_trace_build(scans, seed);
+    check_buttons_init();
+    keys = FlexButtons<CHECK_BUTTON_NUM, CheckConfig>();
+    log_c_num = 0;
+    log_cpp_num = 0;
+
+    start = check_now_ns();
+    for (curr_scan = 0; curr_scan < scans; curr_scan ++)
+    {
+        curr_levels = trace_levels[curr_scan];
+        flex_button_ctx_scan(&check_ctx);
+    }
+    *ns_c += check_now_ns() - start;
+
+    start = check_now_ns();
+    for (curr_scan = 0; curr_scan < scans; curr_scan ++)
+    {
+        curr_levels = trace_levels[curr_scan];
+        keys.scan();
+    }
+    *ns_cpp += check_now_ns() - start;
+
+    if (log_c_num != log_cpp_num)
+    {
+        printf("seed %u: %u events in C, %u in C++\n", (unsigned)seed, (unsigned)log_c_num, (unsigned)log_cpp_num);
+        return -1;
+    }
+
+    for (i = 0; (i < log_c_num) && (i < log_max); i ++)
+    {
+        if (log_c[i] != log_cpp[i])
+        {
+            printf("seed %u: event %u differs, C %016llx, C++ %016llx\n",
+                (unsigned)seed, (unsigned)i, (unsigned long long)log_c[i], (unsigned long long)log_cpp[i]);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t scans = 200000;
+    uint32_t seed;
+    uint32_t events = 0;
+    double ns_c = 0, ns_cpp = 0;
+
+    if (argc > 1)
+    {
+        scans = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+    if ((scans < 1) || (scans > 0x1FFFFFFF / CHECK_BUTTON_NUM))
+    {
+        fprintf(stderr, "scans must be 1 - %u\n", 0x1FFFFFFF / CHECK_BUTTON_NUM);
+        return 1;
+    }
+
+    log_max = scans * CHECK_BUTTON_NUM;
+    trace_levels = (uint32_t *)calloc(scans, sizeof(uint32_t));
+    log_c = (uint64_t *)calloc(log_max, sizeof(uint64_t));
+    log_cpp = (uint64_t *)calloc(log_max, sizeof(uint64_t));
+    if (!trace_levels || !log_c || !log_cpp)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    for (seed = 1; seed <= 16; seed ++)
+    {
+        if (check_run(scans, seed, &ns_c, &ns_cpp) < 0)
+        {
+            return 1;
+        }
+        events += log_c_num;
+    }
+
+    printf("%u buttons, %u scans x 16 traces, %u events identical\n",
+        CHECK_BUTTON_NUM, (unsigned)scans, (unsigned)events);
+    printf("C   %8.1f ns/scan\n", ns_c / scans / 16);
+    printf("C++ %8.1f ns/scan\n", ns_cpp / scans / 16);
+
+    free(trace_levels);
+    free(log_c);
+    free(log_cpp);
+
+    return 0;
+}
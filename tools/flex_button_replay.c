@@ -0,0 +1,415 @@
+/**
+ * @File:    flex_button_replay.c
+ * @Author:  agent
+ * @Date:    2026-10-17
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * message:
+ * Host replay of the traces recorded by flexible_button_trace.c.
+ * The button timing below must match the firmware that recorded the trace.
+ *
+ * Build, in the tools directory, with the same options as the firmware:
+ *     gcc -O2 -I.. -DFLEX_BTN_USING_TRACE flex_button_replay.c \
+ *         ../flexible_button.c ../flexible_button_trace.c -o flex_button_replay
+ *
+ * Usage:
+ *     ./flex_button_replay [-n buttons] trace.bin
+ *         Replay the saved trace blocks, oldest first, and print one line per
+ *         event: "scan id event click_cnt", to diff with a golden file.
+ *     ./flex_button_replay [-n buttons] -f seed scans
+ *         Fuzz: scan random button levels while recording them, then replay
+ *         the trace and check that the scans and the events are the same.
+ *     buttons: number of buttons, default 8, button id is the index.
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flexible_button.h"
+#include "flexible_button_trace.h"
+
+#define SCAN_PERIOD_MS    (1000 / FLEX_BTN_SCAN_FREQ_HZ)
+
+/* Button timing of the firmware */
+#define SHORT_PRESS_MS    1500
+#define LONG_PRESS_MS     3000
+#define LONG_HOLD_MS      4500
+#define DEBOUNCE_TICK     0
+
+/* Scans recorded before each fuzz replay */
+#define FUZZ_ROUND_SCANS  4096
+
+typedef struct
+{
+    uint32_t scan;
+    uint8_t id;
+    uint8_t event;
+    uint16_t click_cnt;
+} replay_event_t;
+
+typedef struct
+{
+    flex_button_ctx_t ctx;
+    flex_button_t buttons[FLEX_BTN_MAX_NUM];
+    replay_event_t *events;
+    uint32_t event_num;
+    uint32_t event_size;
+    uint32_t scan;
+} replay_target_t;
+
+static replay_target_t live;
+static replay_target_t replay;
+static btn_type_t live_levels[FLEX_BTN_STATUS_WORDS];
+
+static void replay_event_add(replay_target_t *target, uint8_t id, uint8_t event, uint16_t click_cnt)
+{
+    if (target->event_num >= target->event_size)
+    {
+        target->event_size = target->event_size ? target->event_size * 2 : 1024;
+        target->events = realloc(target->events, target->event_size * sizeof(replay_event_t));
+        if (!target->events)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+
+    target->events[target->event_num].scan = target->scan;
+    target->events[target->event_num].id = id;
+    target->events[target->event_num].event = event;
+    target->events[target->event_num].click_cnt = click_cnt;
+    target->event_num ++;
+}
+
+static void replay_evt_cb(void *arg)
+{
+    flex_button_t *btn = (flex_button_t *)arg;
+    replay_target_t *target = (btn >= live.buttons && btn < live.buttons + FLEX_BTN_MAX_NUM) ?
+        &live : &replay;
+
+    replay_event_add(target, btn->id, btn->event, btn->click_cnt);
+}
+
+static uint8_t replay_button_read(void *arg)
+{
+    uint32_t i = (uint32_t)((flex_button_t *)arg - live.buttons);
+
+    return (uint8_t)((live_levels[i / FLEX_BTN_WORD_BITS] >> (i % FLEX_BTN_WORD_BITS)) & 1);
+}
+
+static void replay_target_init(replay_target_t *target, uint32_t num)
+{
+    uint32_t i;
+
+    flex_button_ctx_init(&target->ctx);
+#ifdef FLEX_BTN_USING_ARRAY_STORAGE
+    flex_button_ctx_array_init(&target->ctx, target->buttons, (uint16_t)num);
+#endif
+
+    for (i = 0; i < num; i ++)
+    {
+        memset(&target->buttons[i], 0, sizeof(flex_button_t));
+        target->buttons[i].id = (uint8_t)i;
+        target->buttons[i].usr_button_read = replay_button_read;
+        target->buttons[i].cb = replay_evt_cb;
+        target->buttons[i].pressed_logic_level = 1;
+        target->buttons[i].short_press_start_tick = FLEX_MS_TO_SCAN_CNT(SHORT_PRESS_MS);
+        target->buttons[i].long_press_start_tick = FLEX_MS_TO_SCAN_CNT(LONG_PRESS_MS);
+        target->buttons[i].long_hold_start_tick = FLEX_MS_TO_SCAN_CNT(LONG_HOLD_MS);
+        target->buttons[i].debounce_tick = DEBOUNCE_TICK;
+        flex_button_ctx_register(&target->ctx, &target->buttons[i]);
+    }
+}
+
+/**
+ * @brief Scan the target, with the pressing state of a trace or
+ *        with 'live_levels' when pressed is NULL.
+*/
+static void replay_target_scan(replay_target_t *target, const btn_type_t *pressed)
+{
+#ifdef FLEX_BTN_USING_TIMESTAMP
+    uint32_t now = target->scan * SCAN_PERIOD_MS;
+
+    if (pressed)
+    {
+        flex_button_ctx_replay(&target->ctx, pressed, now);
+    }
+    else
+    {
+        flex_button_ctx_scan(&target->ctx, now);
+    }
+#else
+    if (pressed)
+    {
+        flex_button_ctx_replay(&target->ctx, pressed);
+    }
+    else
+    {
+        flex_button_ctx_scan(&target->ctx);
+    }
+#endif
+
+#ifdef FLEX_BTN_USING_EVENT_QUEUE
+    {
+        flex_button_event_record_t record;
+
+        while (flex_button_ctx_event_pop(&target->ctx, &record))
+        {
+            replay_event_add(target, record.id, record.event, record.click_cnt);
+        }
+    }
+#endif
+
+    target->scan ++;
+}
+
+static int replay_file(const char *path, uint32_t num)
+{
+    FILE *fp = fopen(path, "rb");
+    uint8_t *buf = NULL;
+    long size;
+    flex_button_trace_t trace;
+    flex_button_trace_reader_t reader;
+    btn_type_t pressed[FLEX_BTN_STATUS_WORDS];
+    uint32_t i;
+
+    if (!fp)
+    {
+        perror(path);
+        return 1;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size > 0)
+    {
+        buf = malloc((size_t)size);
+    }
+    if (!buf || (fread(buf, 1, (size_t)size, fp) != (size_t)size))
+    {
+        fprintf(stderr, "%s: read error\n", path);
+        fclose(fp);
+        free(buf);
+        return 1;
+    }
+    fclose(fp);
+
+    if (flex_button_trace_load(&trace, buf, (uint32_t)size) < 0)
+    {
+        fprintf(stderr, "%s: not a trace of FLEX_BTN_TRACE_BLOCK_SIZE %u blocks\n",
+            path, (unsigned)FLEX_BTN_TRACE_BLOCK_SIZE);
+        free(buf);
+        return 1;
+    }
+
+    replay_target_init(&replay, num);
+    flex_button_trace_reader_init(&reader, &trace);
+
+    while (flex_button_trace_read(&reader, pressed))
+    {
+        replay.event_num = 0;
+        replay_target_scan(&replay, pressed);
+
+        for (i = 0; i < replay.event_num; i ++)
+        {
+            printf("%lu %u %u %u\n",
+                (unsigned long)replay.events[i].scan,
+                replay.events[i].id,
+                replay.events[i].event,
+                replay.events[i].click_cnt);
+        }
+    }
+
+    free(buf);
+
+    return 0;
+}
+
+/**
+ * @brief Next random level of each button, presses and releases of random length.
+*/
+static void replay_fuzz_levels(uint32_t num, uint16_t *hold)
+{
+    uint32_t i;
+    int r;
+
+    for (i = 0; i < num; i ++)
+    {
+        if (hold[i])
+        {
+            hold[i] --;
+            continue;
+        }
+
+        live_levels[i / FLEX_BTN_WORD_BITS] ^= (btn_type_t)1 << (i % FLEX_BTN_WORD_BITS);
+
+        r = rand() % 10;
+        if (r < 2)
+        {
+            hold[i] = 0; /* bounce */
+        }
+        else if (r < 6)
+        {
+            hold[i] = rand() % 20;
+        }
+        else if (r < 9)
+        {
+            hold[i] = rand() % 100;
+        }
+        else
+        {
+            hold[i] = rand() % 400;
+        }
+    }
+}
+
+static int replay_fuzz(uint32_t seed, uint32_t scans, uint32_t num)
+{
+    static uint8_t buf[FUZZ_ROUND_SCANS * FLEX_BTN_TRACE_BLOCK_SIZE];
+    static btn_type_t expect[FUZZ_ROUND_SCANS][FLEX_BTN_STATUS_WORDS];
+    static uint16_t hold[FLEX_BTN_MAX_NUM];
+    flex_button_trace_t trace;
+    flex_button_trace_reader_t reader;
+    btn_type_t pressed[FLEX_BTN_STATUS_WORDS];
+    uint32_t done = 0;
+    uint32_t n, s, i;
+    uint32_t bytes = 0;
+
+    srand(seed);
+    replay_target_init(&live, num);
+    replay_target_init(&replay, num);
+    flex_button_ctx_trace_hook(&live.ctx, flex_button_trace_record, &trace);
+
+    while (done < scans)
+    {
+        n = (scans - done < FUZZ_ROUND_SCANS) ? scans - done : FUZZ_ROUND_SCANS;
+
+        /* Record */
+        flex_button_trace_init(&trace, buf, sizeof(buf));
+        for (s = 0; s < n; s ++)
+        {
+            replay_fuzz_levels(num, hold);
+            replay_target_scan(&live, NULL);
+            memcpy(expect[s], trace.last, sizeof(expect[s]));
+        }
+        flex_button_trace_flush(&trace);
+        if (trace.count)
+        {
+            bytes += (trace.count - 1) * FLEX_BTN_TRACE_BLOCK_SIZE +
+                flex_button_trace_block(&trace, trace.count - 1)[0];
+        }
+
+        /* Replay */
+        flex_button_trace_reader_init(&reader, &trace);
+        for (s = 0; s < n; s ++)
+        {
+            if (!flex_button_trace_read(&reader, pressed))
+            {
+                fprintf(stderr, "scan %lu: trace ends early\n", (unsigned long)(done + s));
+                return 1;
+            }
+            if (memcmp(pressed, expect[s], sizeof(pressed)))
+            {
+                fprintf(stderr, "scan %lu: pressing state differs\n", (unsigned long)(done + s));
+                return 1;
+            }
+            replay_target_scan(&replay, pressed);
+        }
+        if (flex_button_trace_read(&reader, pressed))
+        {
+            fprintf(stderr, "scan %lu: trace is too long\n", (unsigned long)(done + n));
+            return 1;
+        }
+
+        done += n;
+    }
+
+    if (live.event_num != replay.event_num)
+    {
+        fprintf(stderr, "%lu live events, %lu replayed events\n",
+            (unsigned long)live.event_num, (unsigned long)replay.event_num);
+        return 1;
+    }
+
+    for (i = 0; i < live.event_num; i ++)
+    {
+        replay_event_t *e = &replay.events[i];
+
+        if (memcmp(&live.events[i], e, sizeof(replay_event_t)))
+        {
+            fprintf(stderr, "event %lu differs at scan %lu\n", (unsigned long)i, (unsigned long)e->scan);
+            return 1;
+        }
+
+        /* The click events match the click count */
+        if ((e->event >= FLEX_BTN_PRESS_MAX) ||
+            ((e->event >= FLEX_BTN_PRESS_CLICK) && (e->event <= FLEX_BTN_PRESS_REPEAT_CLICK) &&
+             (e->event != (e->click_cnt < FLEX_BTN_PRESS_REPEAT_CLICK ? e->click_cnt : FLEX_BTN_PRESS_REPEAT_CLICK))))
+        {
+            fprintf(stderr, "event %lu: invalid event %u, click_cnt %u\n",
+                (unsigned long)i, e->event, e->click_cnt);
+            return 1;
+        }
+    }
+
+    printf("seed %lu: %lu scans, %lu events, %lu trace bytes, OK\n",
+        (unsigned long)seed, (unsigned long)scans,
+        (unsigned long)live.event_num, (unsigned long)bytes);
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t num = 8;
+    int arg = 1;
+
+    if ((argc > arg + 1) && !strcmp(argv[arg], "-n"))
+    {
+        num = (uint32_t)strtoul(argv[arg + 1], NULL, 0);
+        arg += 2;
+    }
+
+    if ((num < 1) || (num > FLEX_BTN_MAX_NUM))
+    {
+        fprintf(stderr, "buttons must be 1 - %u\n", (unsigned)FLEX_BTN_MAX_NUM);
+        return 1;
+    }
+
+    if ((argc == arg + 3) && !strcmp(argv[arg], "-f"))
+    {
+        return replay_fuzz((uint32_t)strtoul(argv[arg + 1], NULL, 0),
+            (uint32_t)strtoul(argv[arg + 2], NULL, 0), num);
+    }
+
+    if (argc == arg + 1)
+    {
+        return replay_file(argv[arg], num);
+    }
+
+    fprintf(stderr, "usage: %s [-n buttons] trace.bin\n"
+                    "       %s [-n buttons] -f seed scans\n", argv[0], argv[0]);
+
+    return 1;
+}
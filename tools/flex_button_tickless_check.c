@@ -0,0 +1,516 @@
+/**
+ * @File:    flex_button_tickless_check.c
+ * @Author:  agent
+ * @Date:    2026-10-17
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ * All rights reserved.
+ * License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * message:
+ * Host check of the tickless mode against periodic scanning.
+ * Random level changes, with glitches shorter than one scan period, are
+ * reported with flex_button_notify_edge and handled by flex_button_tickless_scan
+ * at random wakeups, and the events must be the same as scanning the same
+ * levels every 1000 / FLEX_BTN_SCAN_FREQ_HZ ms. Then a few directed cases.
+ *
+ * Build, in the tools directory, with the same options as the firmware:
+ *     gcc -O2 -I.. -DFLEX_BTN_USING_TICKLESS flex_button_tickless_check.c \
+ *         ../flexible_button.c -o flex_button_tickless_check
+ *
+ * Usage:
+ *     ./flex_button_tickless_check [seed [scans]]
+ *
+ * Change logs:
+ * Date        Author       Notes
+ * 2026-10-17  agent        First add
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flexible_button.h"
+
+#ifndef FLEX_BTN_USING_TICKLESS
+#error "Build with FLEX_BTN_USING_TICKLESS"
+#endif
+#if defined(FLEX_BTN_USING_EVENT_QUEUE) || defined(FLEX_BTN_USING_EVENT_BATCH)
+#error "The check reads the events in the button callback"
+#endif
+
+#define SCAN_PERIOD_MS    (1000 / FLEX_BTN_SCAN_FREQ_HZ)
+#define CHECK_BUTTON_NUM  8
+
+/* Longest time between two wakeups of the tickless scan */
+#define CHECK_WAKEUP_MS   300
+
+typedef struct
+{
+    uint32_t scan;
+    uint8_t id;
+    uint8_t event;
+    uint16_t click_cnt;
+} check_event_t;
+
+#ifdef FLEX_BTN_USING_COMBO
+#define CHECK_COMBO_NUM   2
+
+/* Button 0 then button 2 within 1s, buttons 1 and 3 held together for 500ms */
+static const btn_type_t check_combo_steps[CHECK_COMBO_NUM][2 * FLEX_BTN_STATUS_WORDS] = {
+    { 1 << 0, 1 << 2 },
+    { (1 << 1) | (1 << 3) },
+};
+#endif
+
+typedef struct
+{
+    flex_button_ctx_t ctx;
+    flex_button_t buttons[CHECK_BUTTON_NUM];
+#ifdef FLEX_BTN_USING_COMBO
+    flex_button_combo_t combos[CHECK_COMBO_NUM];
+#endif
+    check_event_t *events;
+    uint32_t event_num;
+    uint32_t event_size;
+    uint32_t scan;
+} check_target_t;
+
+typedef struct
+{
+    uint32_t timestamp;
+    uint8_t id;
+} check_edge_t;
+
+static check_target_t periodic;
+static check_target_t tickless;
+static uint8_t levels[CHECK_BUTTON_NUM];
+
+static void check_event_add(check_target_t *target, uint8_t id, uint8_t event, uint16_t click_cnt)
+{
+    if (target->event_num >= target->event_size)
+    {
+        target->event_size = target->event_size ? target->event_size * 2 : 1024;
+        target->events = realloc(target->events, target->event_size * sizeof(check_event_t));
+        if (!target->events)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+
+    target->events[target->event_num].scan = target->scan;
+    target->events[target->event_num].id = id;
+    target->events[target->event_num].event = event;
+    target->events[target->event_num].click_cnt = click_cnt;
+    target->event_num ++;
+}
+
+static void check_evt_cb(void *arg)
+{
+    flex_button_t *btn = (flex_button_t *)arg;
+
+    if ((btn >= periodic.buttons) && (btn < periodic.buttons + CHECK_BUTTON_NUM))
+    {
+        check_event_add(&periodic, btn->id, btn->event, btn->click_cnt);
+    }
+    else
+    {
+        /* The scan that reports the event */
+        tickless.scan = tickless.ctx.last_ts / SCAN_PERIOD_MS;
+        check_event_add(&tickless, btn->id, btn->event, btn->click_cnt);
+    }
+}
+
+#ifdef FLEX_BTN_USING_COMBO
+static void check_combo_cb(void *arg)
+{
+    flex_button_combo_t *combo = (flex_button_combo_t *)arg;
+
+    if ((combo >= periodic.combos) && (combo < periodic.combos + CHECK_COMBO_NUM))
+    {
+        check_event_add(&periodic, combo->id, FLEX_BTN_PRESS_COMBO, 0);
+    }
+    else
+    {
+        tickless.scan = tickless.ctx.last_ts / SCAN_PERIOD_MS;
+        check_event_add(&tickless, combo->id, FLEX_BTN_PRESS_COMBO, 0);
+    }
+}
+#endif
+
+static uint8_t check_button_read(void *arg)
+{
+    return levels[((flex_button_t *)arg)->id];
+}
+
+static void check_target_init(check_target_t *target)
+{
+    uint32_t i;
+
+    flex_button_ctx_init(&target->ctx);
+#ifdef FLEX_BTN_USING_ARRAY_STORAGE
+    flex_button_ctx_array_init(&target->ctx, target->buttons, CHECK_BUTTON_NUM);
+#endif
+    target->event_num = 0;
+    target->scan = 0;
+
+    for (i = 0; i < CHECK_BUTTON_NUM; i ++)
+    {
+        memset(&target->buttons[i], 0, sizeof(flex_button_t));
+        target->buttons[i].id = (uint8_t)i;
+        target->buttons[i].usr_button_read = check_button_read;
+        target->buttons[i].cb = check_evt_cb;
+        target->buttons[i].pressed_logic_level = i & 1;
+        target->buttons[i].max_multiple_clicks_interval = FLEX_MS_TO_SCAN_CNT(200 + i * 20);
+        target->buttons[i].short_press_start_tick = FLEX_MS_TO_SCAN_CNT(400 + i * 100);
+        target->buttons[i].long_press_start_tick = FLEX_MS_TO_SCAN_CNT(1500 + i * 100);
+        target->buttons[i].long_hold_start_tick = FLEX_MS_TO_SCAN_CNT(3000 + i * 100);
+#ifdef FLEX_BTN_USING_DEBOUNCE
+        target->buttons[i].debounce_tick = (uint8_t)(i % 4);
+#endif
+        flex_button_ctx_register(&target->ctx, &target->buttons[i]);
+        levels[i] = !target->buttons[i].pressed_logic_level;
+    }
+
+#ifdef FLEX_BTN_USING_COMBO
+    for (i = 0; i < CHECK_COMBO_NUM; i ++)
+    {
+        memset(&target->combos[i], 0, sizeof(flex_button_combo_t));
+        target->combos[i].steps = check_combo_steps[i];
+        target->combos[i].cb = check_combo_cb;
+        target->combos[i].id = (uint8_t)(CHECK_BUTTON_NUM + i);
+        target->combos[i].step_num = (i == 0) ? 2 : 1;
+        target->combos[i].interval_tick = FLEX_MS_TO_SCAN_CNT(1000);
+        target->combos[i].hold_tick = (i == 0) ? 0 : FLEX_MS_TO_SCAN_CNT(500);
+        flex_button_ctx_combo_register(&target->ctx, &target->combos[i]);
+    }
+#endif
+}
+
+/**
+ * @brief Level changes of the next scan period, presses and releases of
+ *        random length, and glitches that end in the same period.
+ *
+ * @return Number of level changes, sorted by time
+*/
+static uint32_t check_edges(uint32_t scan, uint16_t *hold, check_edge_t *edges)
+{
+    uint32_t n = 0;
+    uint32_t i, k;
+    check_edge_t e;
+    int r;
+
+    for (i = 0; i < CHECK_BUTTON_NUM; i ++)
+    {
+        e.id = (uint8_t)i;
+
+        if ((rand() % 64) == 0)
+        {
+            /* Glitch, two changes between two scans */
+            e.timestamp = (scan - 1) * SCAN_PERIOD_MS + rand() % (SCAN_PERIOD_MS - 1);
+            edges[n ++] = e;
+            e.timestamp += 1 + rand() % (scan * SCAN_PERIOD_MS - 1 - e.timestamp);
+            edges[n ++] = e;
+        }
+
+        if (hold[i])
+        {
+            hold[i] --;
+            continue;
+        }
+
+        e.timestamp = (scan - 1) * SCAN_PERIOD_MS + rand() % SCAN_PERIOD_MS;
+        edges[n ++] = e;
+
+        r = rand() % 10;
+        if (r < 3)
+        {
+            hold[i] = rand() % 4;
+        }
+        else if (r < 7)
+        {
+            hold[i] = rand() % 40;
+        }
+        else
+        {
+            hold[i] = rand() % 250;
+        }
+    }
+
+    /* Insertion sort, few changes */
+    for (i = 1; i < n; i ++)
+    {
+        e = edges[i];
+        for (k = i; (k > 0) && (edges[k - 1].timestamp > e.timestamp); k --)
+        {
+            edges[k] = edges[k - 1];
+        }
+        edges[k] = e;
+    }
+
+    return n;
+}
+
+static int check_random(uint32_t seed, uint32_t scans)
+{
+    static uint16_t hold[CHECK_BUTTON_NUM];
+    check_edge_t edges[CHECK_BUTTON_NUM * 3];
+    uint32_t wakeup = 0;
+    uint32_t wakeups = 0;
+    uint32_t scan, n, k, i;
+
+    srand(seed);
+    check_target_init(&periodic);
+    check_target_init(&tickless);
+    memset(hold, 0, sizeof(hold));
+
+    for (scan = 1; scan <= scans; scan ++)
+    {
+        n = check_edges(scan, hold, edges);
+
+        for (k = 0; k <= n; k ++)
+        {
+            uint32_t t = (k < n) ? edges[k].timestamp : scan * SCAN_PERIOD_MS;
+
+            /* Wakeups before the change */
+            while ((int32_t)(wakeup - t) < 0)
+            {
+                flex_button_ctx_tickless_scan(&tickless.ctx, wakeup);
+                wakeup += 1 + rand() % CHECK_WAKEUP_MS;
+                wakeups ++;
+            }
+
+            if (k == n)
+            {
+                break;
+            }
+
+            levels[edges[k].id] ^= 1;
+            if (flex_button_ctx_notify_edge(&tickless.ctx, edges[k].id,
+                levels[edges[k].id], edges[k].timestamp) > 0)
+            {
+                /* Queue full, the scan thread is woken up at once */
+                flex_button_ctx_tickless_scan(&tickless.ctx, edges[k].timestamp);
+                wakeups ++;
+            }
+        }
+
+        periodic.scan = scan;
+        flex_button_ctx_scan(&periodic.ctx);
+    }
+    flex_button_ctx_tickless_scan(&tickless.ctx, scans * SCAN_PERIOD_MS);
+
+    if (periodic.event_num != tickless.event_num)
+    {
+        fprintf(stderr, "%lu periodic events, %lu tickless events\n",
+            (unsigned long)periodic.event_num, (unsigned long)tickless.event_num);
+    }
+
+    for (i = 0; (i < periodic.event_num) && (i < tickless.event_num); i ++)
+    {
+        if (memcmp(&periodic.events[i], &tickless.events[i], sizeof(check_event_t)))
+        {
+            fprintf(stderr, "event %lu: periodic scan %lu id %u event %u, tickless scan %lu id %u event %u\n",
+                (unsigned long)i,
+                (unsigned long)periodic.events[i].scan, periodic.events[i].id, periodic.events[i].event,
+                (unsigned long)tickless.events[i].scan, tickless.events[i].id, tickless.events[i].event);
+            return 1;
+        }
+    }
+
+    if (periodic.event_num != tickless.event_num)
+    {
+        return 1;
+    }
+
+    printf("seed %lu: %lu scans, %lu events, %lu wakeups, OK\n",
+        (unsigned long)seed, (unsigned long)scans,
+        (unsigned long)periodic.event_num, (unsigned long)wakeups);
+
+    return 0;
+}
+
+/**
+ * @brief Run the tickless scan at its deadlines until the buttons are idle.
+*/
+static void check_settle(uint32_t now)
+{
+    uint32_t deadline;
+
+    flex_button_ctx_tickless_scan(&tickless.ctx, now);
+    while (flex_button_ctx_next_deadline(&tickless.ctx, &deadline))
+    {
+        flex_button_ctx_tickless_scan(&tickless.ctx, deadline);
+    }
+}
+
+static uint32_t check_count(uint8_t id, uint8_t event)
+{
+    uint32_t n = 0;
+    uint32_t i;
+
+    for (i = 0; i < tickless.event_num; i ++)
+    {
+        if ((tickless.events[i].id == id) && (tickless.events[i].event == event))
+        {
+            n ++;
+        }
+    }
+
+    return n;
+}
+
+#ifdef FLEX_BTN_USING_COMBO
+/**
+ * @brief Combinations in tickless mode, the step intervals and the hold time
+ *        must count the scans between the wakeups.
+*/
+static int check_combo(void)
+{
+    uint32_t t;
+    int result = 0;
+
+    /* Button 2 pressed 10s after button 0, with a wakeup every second */
+    check_target_init(&tickless);
+    flex_button_ctx_notify_edge(&tickless.ctx, 0, 0, 100);
+    flex_button_ctx_notify_edge(&tickless.ctx, 0, 1, 200);
+    for (t = 1000; t <= 10000; t += 1000)
+    {
+        flex_button_ctx_tickless_scan(&tickless.ctx, t);
+    }
+    flex_button_ctx_notify_edge(&tickless.ctx, 2, 0, 10050);
+    check_settle(10100);
+    if (check_count(CHECK_BUTTON_NUM, FLEX_BTN_PRESS_COMBO) != 0)
+    {
+        fprintf(stderr, "combination reported after its interval\n");
+        result = 1;
+    }
+
+    /* Button 2 pressed 700ms after button 0, without wakeups in between */
+    check_target_init(&tickless);
+    flex_button_ctx_notify_edge(&tickless.ctx, 0, 0, 100);
+    flex_button_ctx_notify_edge(&tickless.ctx, 0, 1, 200);
+    flex_button_ctx_notify_edge(&tickless.ctx, 2, 0, 900);
+    flex_button_ctx_notify_edge(&tickless.ctx, 2, 1, 1000);
+    check_settle(1000);
+    if (check_count(CHECK_BUTTON_NUM, FLEX_BTN_PRESS_COMBO) != 1)
+    {
+        fprintf(stderr, "combination within its interval not reported once\n");
+        result = 1;
+    }
+
+    /* Buttons 1 and 3 held together, woken up only at the deadlines */
+    check_target_init(&tickless);
+    flex_button_ctx_notify_edge(&tickless.ctx, 1, 1, 100);
+    flex_button_ctx_notify_edge(&tickless.ctx, 3, 1, 110);
+    check_settle(120);
+    if (check_count(CHECK_BUTTON_NUM + 1, FLEX_BTN_PRESS_COMBO) != 1)
+    {
+        fprintf(stderr, "held combination not reported at its deadline\n");
+        result = 1;
+    }
+
+    return result;
+}
+#endif
+
+static int check_directed(void)
+{
+    uint32_t t;
+    int result = 0;
+
+    /* A press and release between two wakeups */
+    check_target_init(&tickless);
+    flex_button_ctx_notify_edge(&tickless.ctx, 0, 0, 100);
+    flex_button_ctx_notify_edge(&tickless.ctx, 0, 1, 180);
+    check_settle(200);
+    if ((check_count(0, FLEX_BTN_PRESS_DOWN) != 1) || (check_count(0, FLEX_BTN_PRESS_CLICK) != 1))
+    {
+        fprintf(stderr, "press shorter than one wakeup: no DOWN and CLICK\n");
+        result = 1;
+    }
+
+    /* Bounce that overflows the queue, ends pressed */
+    check_target_init(&tickless);
+    for (t = 0; t < FLEX_BTN_EDGE_QUEUE_SIZE * 2 + 1; t ++)
+    {
+        flex_button_ctx_notify_edge(&tickless.ctx, 1, !(t & 1), 1000 + t);
+    }
+    check_settle(1000 + t);
+    if ((check_count(1, FLEX_BTN_PRESS_DOWN) != 1) || (tickless.event_num != 1 + check_count(1, FLEX_BTN_PRESS_SHORT_START) +
+        check_count(1, FLEX_BTN_PRESS_LONG_START) + check_count(1, FLEX_BTN_PRESS_LONG_HOLD)))
+    {
+        fprintf(stderr, "queue overflow: not one press\n");
+        result = 1;
+    }
+
+    /* A click after 3 days without any wakeup */
+    check_target_init(&tickless);
+    flex_button_ctx_tickless_scan(&tickless.ctx, 0);
+    t = 3u * 24 * 3600 * 1000;
+    flex_button_ctx_notify_edge(&tickless.ctx, 0, 0, t + 5);
+    flex_button_ctx_notify_edge(&tickless.ctx, 0, 1, t + 85);
+    check_settle(t + 100);
+    if ((tickless.event_num != 2) || (check_count(0, FLEX_BTN_PRESS_DOWN) != 1) ||
+        (check_count(0, FLEX_BTN_PRESS_CLICK) != 1))
+    {
+        fprintf(stderr, "long idle time: no DOWN and CLICK\n");
+        result = 1;
+    }
+    flex_button_ctx_tickless_scan(&tickless.ctx, t + 100000);
+    if ((t + 100000 - tickless.ctx.last_ts) >= SCAN_PERIOD_MS)
+    {
+        fprintf(stderr, "long idle time: the scan time does not follow 'now'\n");
+        result = 1;
+    }
+
+    /* Held for 2 hours without any wakeup */
+    check_target_init(&tickless);
+    flex_button_ctx_notify_edge(&tickless.ctx, 0, 0, 100);
+    flex_button_ctx_tickless_scan(&tickless.ctx, 120);
+    flex_button_ctx_notify_edge(&tickless.ctx, 0, 1, 2 * 3600 * 1000);
+    check_settle(2 * 3600 * 1000 + 20);
+    if ((tickless.event_num != 5) || (check_count(0, FLEX_BTN_PRESS_LONG_HOLD) != 1) ||
+        (check_count(0, FLEX_BTN_PRESS_LONG_HOLD_UP) != 1))
+    {
+        fprintf(stderr, "long hold without wakeups: not one LONG_HOLD and LONG_HOLD_UP\n");
+        result = 1;
+    }
+
+#ifdef FLEX_BTN_USING_COMBO
+    result |= check_combo();
+#endif
+
+    if (!result)
+    {
+        printf("directed cases OK\n");
+    }
+
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t seed = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 1;
+    uint32_t scans = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 200000;
+
+    if (check_random(seed, scans))
+    {
+        return 1;
+    }
+
+    return check_directed();
+}